@@ -0,0 +1,60 @@
+#ifndef __BOUNDED_QUEUE_H_INCLUDED__   // if bounded_queue.h hasn't been included yet...
+#define __BOUNDED_QUEUE_H_INCLUDED__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+
+// Queue between threads holding at most capacity items, so a producer ahead of its consumers waits rather than filling
+// memory. Once closed, pushes fail and pops return what is left, then fail, which lets either side stop the other.
+template<class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(const size_t capacity) : capacity(capacity), closed(false) {}
+
+    // waits for space, false if the queue was closed instead
+    bool push(T item) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return items.size() < capacity or closed; });
+            if (closed)
+                return false;
+            items.push_back(std::move(item));
+        }
+        changed.notify_all();
+        return true;
+    }
+
+    // waits for an item, false if the queue was closed and is empty
+    bool pop(T &item) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return !items.empty() or closed; });
+            if (items.empty())
+                return false;
+            item = std::move(items.front());
+            items.pop_front();
+        }
+        changed.notify_all();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        changed.notify_all();
+    }
+
+private:
+    const size_t capacity;
+    bool closed;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+#endif
@@ -63,7 +63,7 @@ public:
 
     std::string get_max_likelihood_sequence_with_flanks() const;
 
-    void generate_read_pileup(const fs::path &reads_filepath);
+    void generate_read_pileup(const fs::path &reads_filepath, const std::string &read_index_filepath = "");
 
     void write_denovo_paths_to_file(const fs::path &output_directory);
 
@@ -4,6 +4,7 @@
 #include <string>
 #include <cstdint>
 #include <fstream>
+#include <memory>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
@@ -12,17 +13,25 @@
 
 namespace logging = boost::log;
 
+class ReadIndex;
+
+class GzipInflater;
+
 struct FastaqHandler {
+    static const uint64_t min_seek_distance = 1 << 20; //decompressed bytes below which reading on is quicker than seeking
+
     bool gzipped;
     std::ifstream fastaq_file;
+    std::unique_ptr<GzipInflater> inflater; //of fastaq_file if gzipped, from its start or a checkpoint of read_index
     boost::iostreams::filtering_istreambuf inbuf;
     std::istream instream;
     std::string line;
     std::string name;
     std::string read;
     uint32_t num_reads_parsed;
+    std::shared_ptr<ReadIndex> read_index; //if saved while mapping, which get_id seeks with
 
-    FastaqHandler(const std::string &);
+    FastaqHandler(const std::string &, const std::string &read_index_filepath = "");
 
     ~FastaqHandler();
 
@@ -32,6 +41,10 @@ struct FastaqHandler {
 
     void skip_next();
 
+    void discard_buffer();
+
+    bool seek(const uint32_t &);
+
     void get_id(const uint32_t &);
 
     void close();
@@ -0,0 +1,63 @@
+#ifndef __FASTAQ_READER_H_INCLUDED__   // if fastaq_reader.h hasn't been included yet...
+#define __FASTAQ_READER_H_INCLUDED__
+
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+#include "read_index.h"
+
+
+struct FastaqRecord {
+    uint32_t id; //0-based position of the record in the file, as for FastaqHandler::get_id
+    std::string name;
+    std::string seq;
+};
+
+// Reads the records of a FASTA/FASTQ file, gzipped if its name ends in gz, from start to end. One thread decompresses
+// the file into chunks and another parses the chunks into batches of records, each handing over through a bounded
+// queue, so neither holds up whoever processes the records. Batches come in file order, and next_batch may be called
+// from several threads. For random access to reads by id use FastaqHandler, which can seek with the read index
+// given to fill in here.
+class FastaqReader {
+public:
+    static const size_t chunk_size = 1 << 20; //bytes of the file decompressed at a time
+    static const size_t max_batch_records = 1024;
+    static const size_t max_batch_bases = 1 << 22;
+    static const size_t max_queued = 4; //chunks or batches waiting in each queue
+
+    explicit FastaqReader(const std::string &, ReadIndexBuilder * = nullptr);
+
+    ~FastaqReader();
+
+    // stops reading, even if records are left. The read index is complete once the last batch has been taken.
+    void close();
+
+    // the next batch of records, false once there are none left. Rethrows anything thrown reading the file.
+    bool next_batch(std::vector<FastaqRecord> &);
+
+private:
+    std::string filepath;
+    std::ifstream file;
+    ReadIndexBuilder *index;
+    BoundedQueue<std::string> chunks;
+    BoundedQueue<std::vector<FastaqRecord>> batches;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::thread decompressor;
+    std::thread parser;
+
+    bool is_gzipped() const;
+
+    void decompress();
+
+    void parse();
+
+    void set_error(std::exception_ptr);
+};
+
+#endif
@@ -6,14 +6,38 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <limits>
 #include "minirecord.h"
 #include "prg/path.h"
 #include "utils.h"
 
 
+// The MiniRecords stored for one minimizer, contiguous in memory
+struct MiniRecordSpan {
+    const MiniRecord *first;
+    const MiniRecord *last;
+
+    const MiniRecord *begin() const { return first; }
+
+    const MiniRecord *end() const { return last; }
+
+    size_t size() const { return last - first; }
+
+    bool empty() const { return first == last; }
+};
+
+struct MappedIndexFile;
+
+// While PRGs are sketched, records are collected in minhash. freeze() then moves them to an immutable
+// table of sorted keys, offsets and one contiguous array of MiniRecords which is used for lookups. An index loaded
+// from a binary file is looked up in the mapped file instead, and the records of a key are only made into
+// MiniRecords the first time it is found.
 class Index {
 public:
-    std::unordered_map<uint64_t, std::vector<MiniRecord> *> minhash; //map of minimizers to MiniRecords
+    std::unordered_map<uint64_t, std::vector<MiniRecord> *> minhash; //map of minimizers to MiniRecords, only used while building
+    uint32_t max_occurrences = std::numeric_limits<uint32_t>::max(); //minimizers with more records are masked, see mask_frequent_minimizers
+    uint32_t num_prgs = 0; //one more than the largest id of the PRGs indexed, including PRGs without any minimizer
+    std::vector<uint32_t> min_path_lengths; //KmerGraph::min_path_length of each PRG by id, 0 if unknown
 
     Index();
 
@@ -21,24 +45,88 @@ public:
 
     void add_record(const uint64_t, const uint32_t, const prg::Path, const uint32_t, const bool);
 
+    void freeze();
+
+    bool is_frozen() const;
+
+    MiniRecordSpan find(const uint64_t) const;
+
+    void find(const std::vector<uint64_t> &, std::vector<MiniRecordSpan> &) const; //the spans of many minimizers at once
+
+    void find_sorted(const std::vector<uint64_t> &, std::vector<MiniRecordSpan> &) const; //same, for minimizers in increasing order
+
+    size_t num_keys() const;
+
+    size_t num_records() const;
+
+    void mask_frequent_minimizers(const float);
+
+    bool is_masked(const MiniRecordSpan &) const;
+
     void save(const std::string &prgfile, uint32_t w, uint32_t k);
 
-    void save(const std::string &indexfile);
+    void save(const std::string &indexfile); //binary format, see index.cpp
+
+    void save_text(const std::string &indexfile); //legacy tab separated format
 
     void load(const std::string &prgfile, uint32_t w, uint32_t k);
 
-    void load(const std::string &indexfile);
+    void load(const std::string &indexfile); //detects binary or text format from the file itself
+
+    void merge(Index &);
 
     void clear();
 
     bool operator==(const Index &other) const;
 
     bool operator!=(const Index &other) const;
+
+private:
+    // immutable table, the records of keys[i] are records[offsets[i]..offsets[i+1])
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> offsets;
+    std::vector<MiniRecord> records;
+    // if set, the immutable table is the binary index file it maps rather than the vectors above
+    std::shared_ptr<MappedIndexFile> mapped;
+    // the i-th key is in buckets[b]..buckets[b+1] for b == key >> bucket_shift
+    std::vector<uint64_t> buckets;
+    uint32_t bucket_shift = 0;
+    bool frozen = false;
+
+    void thaw();
+
+    void unmap(); //copies a mapped table into the vectors
+
+    const uint64_t *table_keys() const;
+
+    const uint64_t *table_offsets() const;
+
+    MiniRecordSpan table_records(const uint64_t) const; //of the i-th key
+
+    void build_buckets();
+
+    uint64_t bucket(const uint64_t) const;
+
+    std::vector<uint64_t> sorted_keys() const;
+
+    void load_binary(const std::string &indexfile);
+
+    void load_text(const std::string &indexfile);
 };
 
+void merge_index_files(const std::vector<std::string> &, const std::string &);
+
 void index_prgs(std::vector<std::shared_ptr<LocalPRG>> &,
                 std::shared_ptr<Index> &,
                 const uint32_t,
                 const uint32_t,
-                const std::string &);
+                const std::string &,
+                const uint32_t threads = 1);
+
+uint32_t index_new_prgs(std::vector<std::shared_ptr<LocalPRG>> &,
+                        std::shared_ptr<Index> &,
+                        const uint32_t,
+                        const uint32_t,
+                        const std::string &,
+                        const uint32_t threads = 1);
 #endif
@@ -6,10 +6,21 @@
 #include <unordered_map>
 
 
+extern unsigned char seq_nt4_table[256]; //the 2 bit code of each base, 4 if it is not ACGT
+
 uint32_t nt4(char);
 
 uint64_t hash64(uint64_t key, const uint64_t &mask);
 
+// instruction sets hash64_batch can use, from slowest to fastest
+enum class Hash64Isa {
+    scalar, sse2, avx2
+};
+
+Hash64Isa hash64_batch_best_isa(); //the fastest supported by this CPU
+
+void hash64_batch(uint64_t *, const size_t, const uint64_t &mask, Hash64Isa isa = hash64_batch_best_isa()); //hash64 of n keys in place
+
 void test_table();
 
 class KmerHash {
@@ -3,8 +3,11 @@
 
 class LocalPRG;
 
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <vector>
+#include <unordered_map>
 #include <iostream>
 #include "prg/path.h"
 #include "kmernode.h"
@@ -18,10 +21,12 @@ class KmerGraph {
     float nb_p;
     float nb_r;
     int thresh;
+    std::unordered_map<prg::PathId, KmerNodePtr> nodes_by_path; //of nodes, kept by whatever adds to or clears them
+    std::mutex min_path_length_mutex; //so that threads sharing the graph work out min_path_length once
 public:
     uint32_t exp_depth_covg;
     uint32_t num_reads;
-    uint32_t shortest_path_length;
+    std::atomic<uint32_t> shortest_path_length; //memoized by min_path_length, 0 until then
     std::vector<KmerNodePtr> nodes;
     std::vector<KmerNodePtr> sorted_nodes; // representing ordering of the nodes compatible with dp
 
@@ -35,6 +40,8 @@ public:
 
     void clear();
 
+    KmerNodePtr find_node(const prg::PathId) const;
+
     KmerNodePtr add_node(const prg::Path &);
 
     KmerNodePtr add_node_with_kh(const prg::Path &, const uint64_t &, const uint8_t &num = 0);
@@ -87,6 +94,10 @@ public:
 
     void load(const std::string &);
 
+    void encode(std::string &) const; //appends the compact binary form used by KmerGraphStore
+
+    bool decode(const char *&, const char *); //reads back what encode wrote, false if the data is malformed
+
     bool operator==(const KmerGraph &y) const;
 
     void setup_coverages(const uint32_t &);
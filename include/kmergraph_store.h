@@ -0,0 +1,68 @@
+#ifndef __KMERGRAPH_STORE_H_INCLUDED__   // if kmergraph_store.h hasn't been included yet...
+#define __KMERGRAPH_STORE_H_INCLUDED__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "kmergraph.h"
+
+class LocalPRG;
+
+
+// Single file holding the kmer graphs of a range of consecutive PRG ids, written by pandora index in place of one GFA
+// file per PRG. The file is memory mapped and graphs are decoded on demand, see kmergraph_store.cpp for the layout.
+class KmerGraphStore {
+public:
+    explicit KmerGraphStore(const std::string &);
+
+    uint32_t first_id() const { return first; }
+
+    uint32_t end_id() const { return first + num_graphs; } //one past the last PRG id in the store
+
+    bool contains(const uint32_t) const;
+
+    std::string name(const uint32_t) const;
+
+    void load(const uint32_t, KmerGraph &) const;
+
+    uint64_t offset(const uint32_t) const; //position in the file of the graph of PRG first_id() + i
+
+private:
+    std::string filepath;
+    boost::iostreams::mapped_file_source file;
+    uint32_t first;
+    uint32_t num_graphs;
+    uint64_t table_offset;
+};
+
+// Loads the kmer graph of a PRG the first time it is needed, from the stores in a directory or from the GFA files of
+// indexes written by older versions of pandora. Several threads may load graphs at once.
+class KmerGraphLoader {
+public:
+    KmerGraphLoader(const std::string &, const uint32_t, const uint32_t, const uint32_t);
+
+    void load(LocalPRG &);
+
+private:
+    std::string dir;
+    uint32_t w;
+    uint32_t k;
+    uint32_t num_prgs;
+    std::vector<std::unique_ptr<KmerGraphStore>> stores;
+    std::unique_ptr<std::once_flag[]> loaded; //by PRG id
+
+    void load_now(LocalPRG &) const;
+};
+
+std::vector<std::string> find_kmergraph_stores(const std::string &, const uint32_t, const uint32_t);
+
+void save_kmergraph_store(const std::vector<std::shared_ptr<LocalPRG>> &, const std::string &, const uint32_t,
+                          const uint32_t);
+
+uint32_t load_kmergraph_stores(std::vector<std::shared_ptr<LocalPRG>> &, std::vector<bool> &, const std::string &,
+                               const uint32_t, const uint32_t);
+
+#endif
@@ -10,6 +10,7 @@ class KmerNode;
 #include <memory>
 
 #include "prg/path.h"
+#include "prg/path_pool.h"
 #include "pangenome/ns.cpp"
 
 
@@ -19,7 +20,7 @@ class KmerNode {
 
 public:
     uint32_t id;
-    prg::Path path;
+    prg::PathId path_id; // handle of the kmer path in the prg::PathPool
     std::vector<KmerNodePtr> outNodes; // representing edges from this node to the nodes in the vector
     std::vector<KmerNodePtr> inNodes; // representing edges from other nodes to this node
     std::vector<std::pair<uint32_t, uint32_t>> covg_new; // sample covg by hits in fwd, rev dir
@@ -28,10 +29,14 @@ public:
 
     KmerNode(uint32_t, const prg::Path &);
 
+    KmerNode(uint32_t, const prg::PathId);
+
     KmerNode(const KmerNode &);
 
     KmerNode &operator=(const KmerNode &);
 
+    const prg::Path &path() const { return prg::get_path(path_id); }
+
     bool operator==(const KmerNode &y) const;
 
     void increment_covg(const bool &, const uint32_t &sample_id = 0);
@@ -9,6 +9,7 @@
 #include "interval.h"
 #include "index.h"
 #include "localgraph.h"
+#include "memo_cache.h"
 #include "prg/path.h"
 #include "pangenome/pannode.h"
 #include "kmergraph.h"
@@ -20,23 +21,35 @@
 using PanNodePtr = std::shared_ptr<pangenome::Node>;
 namespace fs = boost::filesystem;
 
+class KmerGraphLoader;
+
 class LocalPRG {
     uint32_t next_id; //internal variables used in some methods - TODO: maybe this should not be an object variable
     std::string buff; //internal variables used in some methods - TODO: maybe this should not be an object variable
 
     mutable std::map<prg::Path, std::vector<LocalNodePtr>> nodes_along_path_memoization;
     std::vector<LocalNodePtr> nodes_along_path_core(const prg::Path &) const;
+
+    // walks and shifts recomputed while sketching, bounded by the number of paths they hold, as a walk may have
+    // many, and emptied once the sketch is done
+    static const size_t sketch_memoization_size = 1 << 18;
+    mutable MemoCache<prg::Path, std::vector<prg::Path>, std::hash<prg::Path>, CountElements<std::vector<prg::Path>>>
+            shift_memoization;
+    mutable WalkCache walk_memoization;
+    std::vector<prg::Path> shift_core(prg::Path) const;
 public:
     uint32_t next_site; //denotes the id of the next variant site to be processed - TODO: maybe this should not be an object variable
     uint32_t id; //id of this LocalPRG in the full graph (first gene is 0, second is 1, and so on...)
     std::string name; //name (fasta comment)
     std::string seq; //seq of LocalPRG (the PRG as string itself)
     LocalGraph prg; //the graph that represents this LocalPRG
-    KmerGraph kmer_prg; //the kmer sketch graph
+    KmerGraph kmer_prg; //the kmer sketch graph, see load_kmer_prg
+    std::shared_ptr<KmerGraphLoader> kmer_prg_loader; //if set, kmer_prg is only loaded when first needed
+    uint32_t kmer_prg_min_path_length = 0; //min_path_length of kmer_prg read from the index, 0 if unknown
     //VCF vcf;
     std::vector<uint32_t> num_hits;
 
-    LocalPRG(uint32_t, const std::string &, const std::string &);
+    LocalPRG(uint32_t, const std::string &, const std::string &, const bool build = true); //if not build, prg is left empty for a LocalGraphStore to fill
 
     // functions used to create LocalGraph from PRG string, and to sketch graph
     bool isalpha_string(const std::string &) const;
@@ -57,6 +70,10 @@ public:
 
     void minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w, const uint32_t k);
 
+    void load_kmer_prg();
+
+    uint32_t min_path_length();
+
     // functions used once hits have been collected against the PRG
     std::vector<KmerNodePtr> kmernode_path_from_localnode_path(const std::vector<LocalNodePtr> &) const;
 
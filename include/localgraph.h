@@ -9,11 +9,31 @@
 #include "interval.h"
 #include "prg/path.h"
 #include "localnode.h"
+#include "memo_cache.h"
 #include "IITree.h"
 
 
+// arguments of LocalGraph::walk, to memoize it
+struct WalkArgs {
+    uint32_t node_id;
+    uint32_t pos;
+    uint32_t len;
+
+    bool operator==(const WalkArgs &y) const {
+        return node_id == y.node_id and pos == y.pos and len == y.len;
+    }
+};
+
+struct WalkArgsHash {
+    size_t operator()(const WalkArgs &args) const {
+        return std::hash<uint64_t>()(((uint64_t) args.node_id << 32 | args.pos) * 31 + args.len);
+    }
+};
+
+typedef MemoCache<WalkArgs, std::vector<prg::Path>, WalkArgsHash, CountElements<std::vector<prg::Path>>> WalkCache;
 
 class LocalGraph {
+    std::vector<prg::Path> walk_core(const uint32_t &, const uint32_t &, const uint32_t &, WalkCache *) const;
 public:
     std::map<uint32_t, LocalNodePtr> nodes; // representing nodes in graph
     IITree<uint32_t, LocalNodePtr> intervalTree; //TODO: move to private
@@ -32,7 +52,11 @@ public:
 
     void read_gfa(const std::string &);
 
-    std::vector<prg::Path> walk(const uint32_t &, const uint32_t &, const uint32_t &) const;
+    void encode(std::string &) const; //appends the compact binary form used by LocalGraphStore
+
+    bool decode(const char *&, const char *, const std::string &); //rebuilds the graph of a PRG string from what encode wrote, false if malformed
+
+    std::vector<prg::Path> walk(const uint32_t &, const uint32_t &, const uint32_t &, WalkCache *cache = nullptr) const; //if given, cache memoizes this walk and the walks it is built from
 
     std::vector<prg::Path> walk_back(const uint32_t &, const uint32_t &, const uint32_t &) const;
 
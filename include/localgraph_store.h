@@ -0,0 +1,41 @@
+#ifndef __LOCALGRAPH_STORE_H_INCLUDED__   // if localgraph_store.h hasn't been included yet...
+#define __LOCALGRAPH_STORE_H_INCLUDED__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+class LocalPRG;
+
+
+// Sidecar of a PRG file, written by pandora index, holding the LocalGraph of each PRG in the file so that later commands
+// do not build it from the PRG string again. Graphs are checked against the name and sequence of the PRG they are
+// loaded for, see localgraph_store.cpp for the layout.
+class LocalGraphStore {
+public:
+    explicit LocalGraphStore(const std::string &);
+
+    bool is_valid() const { return valid; }
+
+    uint32_t size() const { return num_prgs; }
+
+    // builds the i-th PRG of the file from its stored graph, nullptr if the store does not match name and seq
+    std::shared_ptr<LocalPRG> load(const uint32_t, const uint32_t, const std::string &, const std::string &) const;
+
+private:
+    std::string filepath;
+    boost::iostreams::mapped_file_source file;
+    bool valid;
+    uint32_t num_prgs;
+    uint64_t table_offset;
+
+    uint64_t offset(const uint32_t) const;
+};
+
+std::string localgraph_store_path(const std::string &);
+
+void save_localgraph_store(const std::vector<std::shared_ptr<LocalPRG>> &, const std::string &);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef __MAPPED_FASTAQ_READER_H_INCLUDED__   // if mapped_fastaq_reader.h hasn't been included yet...
+#define __MAPPED_FASTAQ_READER_H_INCLUDED__
+
+#include <cstdint>
+#include <string>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/utility/string_view.hpp>
+#include "read_index.h"
+
+
+struct FastaqRecordView {
+    uint32_t id; //0-based position of the record in the file, as for FastaqHandler::get_id
+    boost::string_view name;
+    boost::string_view seq;
+};
+
+// Reads the records of an uncompressed FASTA/FASTQ file from start to end as views into the memory mapped file, so
+// records are not copied. The sequence of a record over several lines is joined into a buffer kept between records.
+// Views last until the next call to next, unless is_mapped. Records are the same as FastaqReader gives, which reads
+// gzipped files too.
+class MappedFastaqReader {
+public:
+    explicit MappedFastaqReader(const std::string &, ReadIndexBuilder * = nullptr);
+
+    // the next record, false once there are none left
+    bool next(FastaqRecordView &);
+
+    // if a view is into the mapped file, so lasts as long as the reader rather than until the next record. Names always
+    // are, as are sequences on one line.
+    bool is_mapped(const boost::string_view &) const;
+
+private:
+    boost::iostreams::mapped_file_source file;
+    ReadIndexBuilder *index;
+    const char *pos; //start of the next line
+    const char *end;
+    uint32_t num_records;
+    std::string joined_seq;
+
+    boost::string_view next_line();
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef __MEMO_CACHE_H_INCLUDED__   // if memo_cache.h hasn't been included yet...
+#define __MEMO_CACHE_H_INCLUDED__
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+
+// how much of a MemoCache a value takes up, one for each value by default
+template<class Value>
+struct CountValues {
+    size_t operator()(const Value &) const { return 1; }
+};
+
+// or its number of elements, for values which are containers of varying size
+template<class Value>
+struct CountElements {
+    size_t operator()(const Value &value) const { return value.size(); }
+};
+
+// Results of a function memoized by argument, holding values which add up to at most max_size as counted by Size. When
+// full it is emptied before the next insert, so memory stays bounded on graphs with more distinct arguments than fit.
+// Counts hits and misses so callers can report how well it works.
+template<class Key, class Value, class Hash = std::hash<Key>, class Size = CountValues<Value>>
+class MemoCache {
+public:
+    uint64_t hits;
+    uint64_t misses;
+
+    explicit MemoCache(const size_t max_size) : hits(0), misses(0), max_size(max_size), stored(0) {}
+
+    // the memoized value of key or nullptr, valid until the next insert
+    const Value *find(const Key &key) {
+        const auto it = values.find(key);
+        if (it == values.end()) {
+            ++misses;
+            return nullptr;
+        }
+        ++hits;
+        return &it->second;
+    }
+
+    void insert(const Key &key, const Value &value) {
+        const auto value_size = std::max<size_t>(Size()(value), 1); //so that even empty values are bounded
+        if (value_size > max_size)
+            return;
+        if (stored + value_size > max_size) {
+            values.clear();
+            stored = 0;
+        }
+        if (values.emplace(key, value).second)
+            stored += value_size;
+    }
+
+    void clear() {
+        values.clear();
+        stored = 0;
+        hits = 0;
+        misses = 0;
+    }
+
+    size_t size() const { return values.size(); }
+
+    size_t stored_size() const { return stored; } //of the values held, as counted by Size
+
+private:
+    size_t max_size;
+    size_t stored;
+    std::unordered_map<Key, Value, Hash> values;
+};
+
+#endif
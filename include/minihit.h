@@ -5,13 +5,14 @@
 #include <cstdint>
 #include "minimizer.h"
 #include "minirecord.h"
+#include "prg/path_pool.h"
 
 
 struct MinimizerHit {
     uint32_t read_id;
     uint32_t read_start_position;
     uint32_t prg_id;
-    prg::Path prg_path;
+    prg::PathId prg_path_id; //handle of the kmer path in the prg::PathPool
     uint32_t kmer_node_id;
     bool is_forward;
 
@@ -20,6 +21,8 @@ struct MinimizerHit {
     MinimizerHit(const uint32_t read_id, const Interval read_interval, const uint32_t prg_id, const prg::Path prg_path,
                  const uint32_t kmer_node_id, const bool is_forward);
 
+    const prg::Path &prg_path() const { return prg::get_path(prg_path_id); }
+
     bool operator<(const MinimizerHit &y) const;
 
     bool operator==(const MinimizerHit &y) const;
@@ -27,5 +30,8 @@ struct MinimizerHit {
     friend std::ostream &operator<<(std::ostream &out, const MinimizerHit &m);
 };
 
+// reads keep their hits by value, so a hit should stay a few words
+static_assert(sizeof(MinimizerHit) == 24, "MinimizerHit is expected to take 24 bytes");
+
 
 #endif
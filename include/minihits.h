@@ -2,7 +2,7 @@
 #define __MINIHITS_H_INCLUDED__
 
 #include <set>
-#include <unordered_set>
+#include <vector>
 #include <memory>
 #include "minimizer.h"
 #include "minirecord.h"
@@ -24,7 +24,9 @@ struct Hash {
 };
 
 struct pComp_path {
-    bool operator()(const MinimizerHitPtr &lhs, const MinimizerHitPtr &rhs);
+    bool operator()(const MinimizerHitPtr &lhs, const MinimizerHitPtr &rhs) const;
+
+    bool operator()(const MinimizerHit &lhs, const MinimizerHit &rhs) const;
 };
 
 struct clusterComp {
@@ -43,8 +45,7 @@ public:
 
     void clear();
 
-    //std::unordered_set<MinimizerHit*, Hash, pEq> uhits;
-    std::unordered_set<MinimizerHitPtr> uhits;
+    std::vector<MinimizerHitPtr> uhits; //in the order added, each hit is a new one
     std::set<MinimizerHitPtr, pComp> hits;
 
     void add_hit(const uint32_t i, const Minimizer &m, const MiniRecord *r);
@@ -52,6 +53,12 @@ public:
     void sort();
 
     friend std::ostream &operator<<(std::ostream &out, const MinimizerHits &m);
+
+private:
+    // hits are made in blocks rather than one allocation each. A hit pointer shares ownership of its whole block, so
+    // clusters kept after clear() still point to valid hits. A block is never reused: hits are only ever appended to
+    // it, and it is freed once nothing points to it any more.
+    std::shared_ptr<std::vector<MinimizerHit>> block;
 };
 
 #endif
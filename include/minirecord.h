@@ -4,17 +4,22 @@
 #include <iostream>
 #include <cstdint>
 #include "prg/path.h"
+#include "prg/path_pool.h"
 
 //Minimizer Record
 struct MiniRecord {
     uint32_t prg_id; //prg id of the minimizer
-    prg::Path path; //kmer path of the minimizer
+    prg::PathId path_id; //handle of the kmer path of the minimizer in the prg::PathPool
     uint32_t knode_id; //kmer graph node id
     bool strand;
 
     MiniRecord();
 
-    MiniRecord(const uint32_t, const prg::Path, const uint32_t, const bool);
+    MiniRecord(const uint32_t, const prg::Path &, const uint32_t, const bool);
+
+    MiniRecord(const uint32_t, const prg::PathId, const uint32_t, const bool);
+
+    const prg::Path &path() const { return prg::get_path(path_id); }
 
     ~MiniRecord();
 
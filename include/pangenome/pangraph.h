@@ -38,8 +38,6 @@ public:
     void clear();
 
     // graph additions/removals
-    void reserve_num_reads(uint32_t &);
-
     ReadPtr get_read(const uint32_t &);
 
     NodePtr get_node(const NodeId &,
@@ -92,7 +90,8 @@ public:
     // graph read/write
     void save_matrix(const std::string &);
 
-    void save_mapped_read_strings(const std::string &read_filepath, const std::string &outprefix, const int buff = 0);
+    void save_mapped_read_strings(const std::string &read_filepath, const std::string &outprefix, const int buff = 0,
+                                  const std::string &read_index_filepath = "");
 
     friend std::ostream &operator<<(std::ostream &out, const Graph &m);
 
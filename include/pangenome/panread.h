@@ -7,6 +7,7 @@
 #include <iostream>
 #include <unordered_map>
 #include "minihits.h"
+#include "minihit.h"
 #include "pangenome/ns.cpp"
 
 
@@ -16,7 +17,7 @@ public:
     std::vector<NodePtr> nodes;
     std::vector<bool> node_orientations;
 
-    std::unordered_map<uint32_t, std::set<MinimizerHitPtr, pComp_path>> hits; // from node id to cluster of hits against that node in this read
+    std::unordered_map<uint32_t, std::vector<MinimizerHit>> hits; // from prg id to the hits against that prg in this read, ordered by pComp_path
 
     Read(const uint32_t);
 
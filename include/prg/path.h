@@ -5,6 +5,7 @@
 #include <vector>
 #include <iostream>
 #include <cstdint>
+#include <functional>
 #include "interval.h"
 #include "prg/ns.cpp"
 
@@ -50,4 +51,11 @@ public:
 
 bool equal_except_null_nodes(const prg::Path &, const prg::Path &);
 
+namespace std {
+    template<>
+    struct hash<prg::Path> {
+        size_t operator()(const prg::Path &) const;
+    };
+}
+
 #endif
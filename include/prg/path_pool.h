@@ -0,0 +1,96 @@
+#ifndef __PATH_POOL_H_INCLUDED__   // if path_pool.h hasn't been included yet...
+#define __PATH_POOL_H_INCLUDED__
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include "prg/path.h"
+
+
+namespace prg {
+    typedef uint32_t PathId;
+
+    // Process-wide store of distinct paths, so that the index, minimizer hits and kmer graphs share one copy of each
+    // kmer path and hold a 32 bit handle to it. Equal paths get equal handles, and a handle refers to the same path
+    // for the lifetime of the program. Interning may be called from several threads: paths are split by hash between
+    // shards which are locked separately, so threads interning different paths rarely wait for each other.
+    class PathPool {
+    public:
+        static PathPool &instance();
+
+        PathId intern(const Path &);
+
+        const Path &get(const PathId id) const {
+            return shards[id >> local_bits].get(id & local_mask);
+        }
+
+        bool less(const PathId, const PathId) const;
+
+        size_t size() const;
+
+    private:
+        // a handle is the shard in its top bits and the position of the path in that shard below
+        static const uint32_t shard_bits = 6;
+        static const uint32_t num_shards = 1u << shard_bits;
+        static const uint32_t local_bits = 32 - shard_bits;
+        static const uint32_t local_mask = (1u << local_bits) - 1;
+        // chunk c of a shard holds 2^(first_chunk_bits + c) paths, so a shard allocates at most about twice what it holds
+        static const uint32_t first_chunk_bits = 8;
+        static const uint32_t max_chunks = local_bits - first_chunk_bits + 1;
+
+        struct Shard;
+
+        // of the paths of a shard, by their position in it
+        struct IdHash {
+            const Shard *shard;
+
+            size_t operator()(const uint32_t) const;
+        };
+
+        struct IdEqual {
+            const Shard *shard;
+
+            bool operator()(const uint32_t, const uint32_t) const;
+        };
+
+        struct Shard {
+            // paths are stored in chunks which are never moved, so get() needs no lock
+            std::atomic<Path *> chunks[max_chunks];
+            uint32_t num_paths;
+            size_t staged_hash; //of the path in the first free slot, hashed once to pick the shard
+            std::unordered_set<uint32_t, IdHash, IdEqual> ids;
+            mutable std::mutex mutex;
+
+            Shard();
+
+            ~Shard();
+
+            const Path &get(const uint32_t local) const {
+                const uint32_t position = local + (1u << first_chunk_bits);
+                const uint32_t chunk = 31 - __builtin_clz(position) - first_chunk_bits;
+                return chunks[chunk].load(std::memory_order_acquire)[position - (1u << (chunk + first_chunk_bits))];
+            }
+
+            Path &slot(const uint32_t local);
+        };
+
+        Shard shards[num_shards];
+
+        PathPool() = default;
+
+        PathPool(const PathPool &) = delete;
+
+        PathPool &operator=(const PathPool &) = delete;
+    };
+
+    inline PathId intern(const Path &path) {
+        return PathPool::instance().intern(path);
+    }
+
+    inline const Path &get_path(const PathId id) {
+        return PathPool::instance().get(id);
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __READ_INDEX_H_INCLUDED__   // if read_index.h hasn't been included yet...
+#define __READ_INDEX_H_INCLUDED__
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+
+// A place to start decompressing a gzip file from without decompressing what comes before it
+struct GzipCheckpoint {
+    uint64_t uncompressed_offset;
+    uint64_t compressed_offset; //of the first byte not wholly decompressed
+    uint64_t window_offset; //into the windows of the read index
+    uint32_t window_size; //bytes decompressed just before the checkpoint, which the data after it can refer back to
+    uint16_t bits; //of the byte before compressed_offset which are still to be decompressed
+    uint16_t member_start; //if the checkpoint is at the start of a gzip member, so is decompressed as a new file
+};
+
+// Offsets of the reads of a FASTA/FASTQ file, filled in by FastaqReader as it reads the file through, and saved by map
+// in its output directory for FastaqHandler::get_id to seek with
+struct ReadIndexBuilder {
+    bool gzipped;
+    uint64_t checkpoint_span; //decompressed bytes between gzip checkpoints
+    std::vector<uint64_t> read_offsets; //in the decompressed file, of the name line of each read
+    std::vector<GzipCheckpoint> checkpoints;
+    std::string windows;
+
+    ReadIndexBuilder() : gzipped(false), checkpoint_span(1 << 22) {}
+
+    void save(const std::string &readfile, const std::string &filepath) const;
+};
+
+// The read index saved for a read file, if it is there and the read file has not changed since. Memory mapped, so
+// opening it costs the same however many reads it has. See read_index.cpp for the layout.
+class ReadIndex {
+public:
+    ReadIndex(const std::string &readfile, const std::string &filepath);
+
+    bool is_valid() const { return valid; }
+
+    bool is_gzipped() const { return gzipped; }
+
+    uint32_t num_reads() const { return num_reads_indexed; }
+
+    uint64_t read_offset(const uint32_t) const;
+
+    // the last checkpoint at or before an offset in the decompressed file, for a gzipped read file
+    const GzipCheckpoint &checkpoint_before(const uint64_t) const;
+
+    const char *window(const GzipCheckpoint &) const;
+
+private:
+    boost::iostreams::mapped_file_source file;
+    bool valid;
+    bool gzipped;
+    uint32_t num_reads_indexed;
+    const uint64_t *read_offsets;
+    const GzipCheckpoint *checkpoints;
+    uint64_t num_checkpoints;
+    const char *windows;
+};
+
+// where the read index of a read file is saved in a directory
+std::string read_index_path(const std::string &readfile, const std::string &dir);
+
+// Decompresses a gzip file of one or more members, as written by gzip or bgzip, either from its start, adding
+// checkpoints to an index on the way if given one, or from a checkpoint
+class GzipInflater {
+public:
+    explicit GzipInflater(std::istream &, ReadIndexBuilder * = nullptr);
+
+    GzipInflater(std::istream &, const GzipCheckpoint &, const char *);
+
+    ~GzipInflater();
+
+    GzipInflater(const GzipInflater &) = delete;
+
+    GzipInflater &operator=(const GzipInflater &) = delete;
+
+    // decompresses up to the given number of bytes, fewer only at the end of the file. Throws std::runtime_error if the
+    // file is corrupt or truncated.
+    size_t read(char *, const size_t);
+
+private:
+    std::istream &file;
+    ReadIndexBuilder *index;
+    z_stream strm;
+    std::vector<unsigned char> input;
+    std::vector<unsigned char> window; //ring of the last 32 KiB decompressed, ending at window_pos
+    size_t window_pos;
+    bool raw; //if started from a checkpoint inside a member, which zlib decompresses without its gzip header
+    bool at_member_start;
+    bool finished;
+    uint64_t input_end; //offset in the file of the byte after the last one read into input
+    uint64_t uncompressed_offset;
+    uint64_t member_size; //bytes decompressed since the start of the member
+    uint64_t last_checkpoint;
+
+    bool fill_input();
+
+    void add_checkpoint();
+};
+
+#endif
@@ -3,9 +3,11 @@
 
 #include <string>
 #include <cstdint>
-#include <set>
+#include <vector>
 #include <ostream>
+#include <boost/utility/string_view.hpp>
 #include "minimizer.h"
+#include "interval.h"
 
 
 class Seq {
@@ -13,22 +15,18 @@ public:
     uint32_t id;
     std::string name;
     std::string seq;
-    std::set<Minimizer> sketch;
+    std::vector<Minimizer> sketch; //distinct minimizers in order of position along seq
+    std::vector<uint64_t> forward_kmers, reverse_kmers; //hashes of the kmers starting at each position, kept between reads
+    uint32_t num_ambiguous_bases; //non ACGT bases, which the sketch skips over
 
     Seq(uint32_t, std::string, std::string, uint32_t, uint32_t);
 
     ~Seq();
 
-    void initialize(uint32_t, std::string, std::string, uint32_t, uint32_t);
+    // resketches as another read, reusing the space of the last. The name and sequence may be views into a mapped file.
+    void initialize(uint32_t, const boost::string_view &, const boost::string_view &, uint32_t, uint32_t);
 
-    bool add_letter_to_get_next_kmer(const char &, const uint64_t &, const uint64_t &, uint32_t &, uint64_t (&)[2],
-                                     uint64_t (&)[2]);
-
-    void add_minimizing_kmers_to_sketch(const std::vector<Minimizer> &, const uint64_t &);
-
-    void minimize_window(std::vector<Minimizer> &, uint64_t &);
-
-    void add_new_smallest_minimizer(std::vector<Minimizer> &, uint64_t &);
+    void hash_kmers(const uint32_t, std::vector<Interval> &);
 
     void minimizer_sketch(const uint32_t w, const uint32_t k);
 
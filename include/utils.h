@@ -53,17 +53,47 @@ std::string rev_complement(std::string);
 
 float lognchoosek2(uint32_t, uint32_t, uint32_t);
 
+void encode_varint(std::string &, uint32_t);
+
+bool decode_varint(const char *&, const char *, uint32_t &);
+
 //probably should be moved to map_main.cpp
 void read_prg_file(std::vector<std::shared_ptr<LocalPRG>> &,
-                   const std::string &, uint32_t id=0);
+                   const std::string &, uint32_t id=0, const uint32_t threads=1);
 
 void
 load_PRG_kmergraphs(std::vector<std::shared_ptr<LocalPRG>> &, const uint32_t &, const uint32_t &, const std::string &);
 
+void load_PRG_kmergraphs_on_demand(std::vector<std::shared_ptr<LocalPRG>> &, const uint32_t &, const uint32_t &,
+                                   const std::string &, const Index &);
+
 void load_vcf_refs_file(const std::string &, VCFRefs &);
 
 //void add_read_hits(uint32_t, const std::string&, const std::string&, MinimizerHits*, Index*, const uint32_t, const uint32_t);
-void add_read_hits(std::shared_ptr<Seq>, std::shared_ptr<MinimizerHits>, std::shared_ptr<Index>);
+uint32_t add_read_hits(std::shared_ptr<Seq>, std::shared_ptr<MinimizerHits>, std::shared_ptr<Index>);
+
+// The minimizers of a batch of reads, whose hits add_read_batch_hits finds all together. A batch is full once it is
+// expected to find about max_hits hits, at the hits per minimizer found for the batch before it.
+struct ReadBatch {
+    std::vector<uint32_t> read_ids; //of each minimizer
+    std::vector<Minimizer> minimizers;
+    size_t max_hits;
+    size_t max_minimizers; //of a full batch
+
+    explicit ReadBatch(const size_t max_hits = 1 << 20);
+
+    void add(const Seq &);
+
+    bool is_full() const;
+
+    void found_hits(const size_t); //for the minimizers of this batch, sizing the batches after it
+
+    void clear();
+};
+
+void radix_sort(std::vector<std::pair<uint64_t, uint32_t>> &);
+
+uint32_t add_read_batch_hits(const ReadBatch &, std::shared_ptr<MinimizerHits>, std::shared_ptr<Index>);
 
 void define_clusters(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &,
                      const std::vector<std::shared_ptr<LocalPRG>> &,
@@ -73,6 +103,10 @@ void filter_clusters(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &);
 
 void filter_clusters2(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &, const uint32_t &);
 
+void cluster_read_hits(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &,
+                       const std::vector<std::shared_ptr<LocalPRG>> &, std::shared_ptr<MinimizerHits>, const int,
+                       const float &, const uint32_t, const uint32_t);
+
 void
 infer_localPRG_order_for_reads(const std::vector<std::shared_ptr<LocalPRG>> &prgs, std::shared_ptr<MinimizerHits>,
                                std::shared_ptr<pangenome::Graph>,
@@ -87,7 +121,8 @@ uint32_t pangraph_from_read_file(const std::string &, std::shared_ptr<MinimizerH
                                  const uint32_t min_cluster_size = 10,
                                  const uint32_t genome_size = 5000000, const bool illumina = false,
                                  const bool clean = false,
-                                 const uint32_t max_covg = 300);
+                                 const uint32_t max_covg = 300, const bool sort_merge_hits = false,
+                                 const std::string &read_index_filepath = "", const uint32_t threads = 1);
 
 //, const uint32_t, const float&, bool);
 void infer_most_likely_prg_path_for_pannode(const std::vector<std::shared_ptr<LocalPRG>> &, PanNode *, uint32_t, float);
@@ -123,7 +123,7 @@ int pandora_check_kmergraph(int argc, char *argv[]) // the "pandora check_kmergr
                     cout << "kmers on path: " << endl;
                             for (uint j=0; j != kpath.size(); ++j)
                             {
-                                cout << kpath[j]->id << " " << kpath[j]->path << endl;
+                                cout << kpath[j]->id << " " << kpath[j]->path() << endl;
                             }
 
                         cout << "kmer path: " << kpath[0]->id;
@@ -133,11 +133,11 @@ int pandora_check_kmergraph(int argc, char *argv[]) // the "pandora check_kmergr
                                 {
                                     cout << "->" << kpath[j]->id;
                                 } else {
-                                    cout << endl << "no edge from " << kpath[j-1]->path << " to " << kpath[j]->path << endl;
+                                    cout << endl << "no edge from " << kpath[j-1]->path() << " to " << kpath[j]->path() << endl;
                         cout << "outnodes are: " << endl;
                         for (uint n=0; n!= kpath[j-1]->outNodes.size(); ++n)
                         {
-                        cout << kpath[j-1]->outNodes[n]->path << endl;
+                        cout << kpath[j-1]->outNodes[n]->path() << endl;
                         }
 
                                 }
@@ -197,7 +197,7 @@ int pandora_check_kmergraph(int argc, char *argv[]) // the "pandora check_kmergr
                 cout << "kmers on path: " << endl;
                 for (uint j=0; j != kpath.size(); ++j)
                 {
-                    cout << kpath[j]->id << " " << kpath[j]->path << endl;
+                    cout << kpath[j]->id << " " << kpath[j]->path() << endl;
                 }
 
                 cout << "kmer path: " << kpath[0]->id;
@@ -207,11 +207,11 @@ int pandora_check_kmergraph(int argc, char *argv[]) // the "pandora check_kmergr
                     {
                         cout << "->" << kpath[j]->id;
                     } else {
-                cout << endl << "no edge from " << kpath[j-1]->path << " to " << kpath[j]->path << endl;
+                cout << endl << "no edge from " << kpath[j-1]->path() << " to " << kpath[j]->path() << endl;
                         cout << "outnodes are: " << endl;
                         for (uint n=0; n!= kpath[j-1]->outNodes.size(); ++n)
                         {
-                            cout << kpath[j-1]->outNodes[n]->path << endl;
+                            cout << kpath[j-1]->outNodes[n]->path() << endl;
                         }
 
                     }
@@ -47,6 +47,7 @@ static void show_compare_usage() {
               << "\t-o,--outdir OUTDIR\tSpecify directory of output\n"
               << "\t-w W\t\t\t\tWindow size for (w,k)-minimizers, default 14\n"
               << "\t-k K\t\t\t\tK-mer size for (w,k)-minimizers, default 15\n"
+              << "\t-t,--threads T\t\t\tNumber of threads used to load the PRGs and map the reads, default 1\n"
               << "\t-m,--max_diff INT\t\tMaximum distance between consecutive hits within a cluster, default 250 (bps)\n"
               << "\t-e,--error_rate FLOAT\t\tEstimated error rate for reads, default 0.11\n"
               << "\t--genome_size\tNUM_BP\tEstimated length of genome, used for coverage estimation\n"
@@ -56,6 +57,10 @@ static void show_compare_usage() {
               << "\t--clean\t\t\tAdd a step to clean and detangle the pangraph\n"
               << "\t--bin\t\t\tUse binomial model for kmer coverages, default is negative binomial\n"
               << "\t--max_covg\t\t\tMaximum average coverage from reads to accept\n"
+              << "\t--max_freq FLOAT|INT\t\tIgnore minimizers occurring more than INT times in the index, or the FLOAT\n"
+              << "\t\t\t\t\tfraction of most frequent minimizers if below 1, default 0 (keep all)\n"
+              << "\t--sort_merge_hits\t\tFind hits for a batch of reads at a time, by sorting their minimizers and\n"
+              << "\t\t\t\t\tmerging them with the index, which is faster for high coverage short reads\n"
               << "\t--genotype\t\t\tAdd extra step to carefully genotype sites\n"
               << "\t--log_level\t\t\tdebug,[info],warning,error\n"
               << std::endl;
@@ -97,12 +102,12 @@ int pandora_compare(int argc, char *argv[]) {
 
     // otherwise, parse the parameters from the command line
     std::string prgfile, read_index_fpath, outdir = "pandora", vcf_refs_file, log_level="info";
-    uint32_t w = 14, k = 15, min_cluster_size = 10, genome_size = 5000000, max_covg = 300, min_allele_covg_gt = 0,
+    uint32_t w = 14, k = 15, min_cluster_size = 10, genome_size = 5000000, max_covg = 300, threads = 1, min_allele_covg_gt = 0,
             min_total_covg_gt = 0, min_diff_covg_gt = 0, min_kmer_covg=0; // default parameters
     uint16_t confidence_threshold = 1;
     int max_diff = 250;
-    float e_rate = 0.11, min_allele_fraction_covg_gt = 0, genotyping_error_rate=0.01;
-    bool illumina = false, clean = false, bin = false, genotype = false;
+    float e_rate = 0.11, min_allele_fraction_covg_gt = 0, genotyping_error_rate=0.01, max_freq = 0;
+    bool illumina = false, clean = false, bin = false, genotype = false, sort_merge_hits = false;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if ((arg == "-h") || (arg == "--help")) {
@@ -143,6 +148,13 @@ int pandora_compare(int argc, char *argv[]) {
                 std::cerr << "-k option requires one argument." << std::endl;
                 return 1;
             }
+        } else if ((arg == "-t") || (arg == "--threads")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                threads = (unsigned) atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--threads option requires one argument." << std::endl;
+                return 1;
+            }
         } else if ((arg == "-m") || (arg == "--max_diff")) {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
                 max_diff = atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
@@ -187,6 +199,15 @@ int pandora_compare(int argc, char *argv[]) {
             clean = true;
         } else if ((arg == "--bin")) {
             bin = true;
+        } else if ((arg == "--sort_merge_hits")) {
+            sort_merge_hits = true;
+        } else if ((arg == "--max_freq")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                max_freq = static_cast<float>(atof(argv[++i])); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--max_freq option requires one argument." << std::endl;
+                return 1;
+            }
         } else if ((arg == "--max_covg")) {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
                 max_covg = atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
@@ -274,6 +295,9 @@ int pandora_compare(int argc, char *argv[]) {
     std::cout << "\tclean\t" << clean << std::endl;
     std::cout << "\tbin\t" << bin << std::endl << std::endl;
     std::cout << "\tmax_covg\t" << max_covg << std::endl;
+    std::cout << "\tmax_freq\t" << max_freq << std::endl;
+    std::cout << "\tsort_merge_hits\t" << sort_merge_hits << std::endl;
+    std::cout << "\tthreads\t" << threads << std::endl;
     std::cout << "\tgenotype\t" << genotype << std::endl;
     std::cout << "\tlog_level\t" << log_level << std::endl << std::endl;
 
@@ -285,9 +309,10 @@ int pandora_compare(int argc, char *argv[]) {
     std::cout << now() << "Loading Index and LocalPRGs from file" << std::endl;
     auto index = std::make_shared<Index>();
     index->load(prgfile, w, k);
+    index->mask_frequent_minimizers(max_freq);
     std::vector<std::shared_ptr<LocalPRG>> prgs;
-    read_prg_file(prgs, prgfile);
-    load_PRG_kmergraphs(prgs, w, k, prgfile);
+    read_prg_file(prgs, prgfile, 0, threads);
+    load_PRG_kmergraphs_on_demand(prgs, w, k, prgfile, *index);
 
     // load read index
     std::cout << now() << "Loading read index file " << read_index_fpath << std::endl;
@@ -327,7 +352,8 @@ int pandora_compare(int argc, char *argv[]) {
                                                 pangraph_sample,
                                                 index, prgs, w, k,
                                                 max_diff, e_rate,
-                                                min_cluster_size, genome_size, illumina, clean, max_covg);
+                                                min_cluster_size, genome_size, illumina, clean, max_covg,
+                                                sort_merge_hits, "", threads);
         BOOST_LOG_TRIVIAL(info) << "Finished with minihits, so clear ";
         minimizer_hits->clear();
 
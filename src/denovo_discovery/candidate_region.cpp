@@ -123,8 +123,8 @@ identify_low_coverage_intervals(const std::vector<uint32_t> &covg_at_each_positi
 }
 
 
-void CandidateRegion::generate_read_pileup(const fs::path &reads_filepath) {
-    FastaqHandler readfile(reads_filepath.string());
+void CandidateRegion::generate_read_pileup(const fs::path &reads_filepath, const std::string &read_index_filepath) {
+    FastaqHandler readfile(reads_filepath.string(), read_index_filepath);
     if (readfile.eof()) return;
 
     uint32_t last_id { 0 };
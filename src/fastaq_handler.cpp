@@ -1,15 +1,40 @@
 #include <string>
 #include <cstring>
 #include <iostream>
+#include <vector>
 //#include <fstream>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/copy.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
 #include "fastaq_handler.h"
+#include "read_index.h"
 #include "utils.h"
 
 
-FastaqHandler::FastaqHandler(const std::string &filepath) : gzipped(false), instream(&inbuf), num_reads_parsed(0) {
+namespace {
+    // boost source reading the file of a FastaqHandler from wherever the file, or its inflater if gzipped, was last
+    // moved to, so that the handler can move about the file without changing its chain of streams
+    struct FastaqSource {
+        typedef char char_type;
+        typedef boost::iostreams::source_tag category;
+
+        FastaqHandler *handler;
+
+        std::streamsize read(char *s, std::streamsize n) {
+            std::streamsize num_read;
+            if (handler->inflater != nullptr) {
+                num_read = handler->inflater->read(s, n);
+            } else {
+                handler->fastaq_file.read(s, n);
+                num_read = handler->fastaq_file.gcount();
+            }
+            return num_read == 0 ? -1 : num_read;
+        }
+    };
+}
+
+
+FastaqHandler::FastaqHandler(const std::string &filepath, const std::string &read_index_filepath)
+        : gzipped(false), instream(&inbuf), num_reads_parsed(0) {
     // level for boost logging
 //    logging::core::get()->set_filter(logging::trivial::severity >= g_log_level);
 
@@ -19,15 +44,19 @@ FastaqHandler::FastaqHandler(const std::string &filepath) : gzipped(false), inst
         std::cerr << "Unable to open fastaq file " << filepath << std::endl;
         std::exit(EXIT_FAILURE);
     }
-    try {
-        if (filepath.substr(filepath.length() - 2) == "gz") {
-            inbuf.push(boost::iostreams::gzip_decompressor());
-            gzipped = true;
-        }
-        inbuf.push(fastaq_file);
+    if (filepath.substr(filepath.length() - 2) == "gz") {
+        inflater.reset(new GzipInflater(fastaq_file));
+        gzipped = true;
     }
-    catch (const boost::iostreams::gzip_error &e) {
-        std::cerr << "Problem transfering file contents to boost stream: " << e.what() << '\n';
+    inbuf.push(FastaqSource{this});
+
+    if (read_index_filepath.empty())
+        return;
+    read_index = std::make_shared<ReadIndex>(filepath, read_index_filepath);
+    if (read_index->is_valid() and read_index->is_gzipped() == gzipped) {
+        BOOST_LOG_TRIVIAL(debug) << "Found offsets of " << read_index->num_reads() << " reads in " << filepath;
+    } else {
+        read_index.reset();
     }
 }
 
@@ -121,9 +150,49 @@ void print(std::istream &infile) {
     }
 }
 
+// Moves to just before read id with the read index, if it has the read and that is quicker than reading on to it
+bool FastaqHandler::seek(const uint32_t &id) {
+    if (read_index == nullptr or id >= read_index->num_reads())
+        return false;
+    const uint64_t offset = read_index->read_offset(id);
+    const GzipCheckpoint *checkpoint = gzipped ? &read_index->checkpoint_before(offset) : nullptr;
+    const uint64_t entry_offset = gzipped ? checkpoint->uncompressed_offset : offset;
+    const bool behind = id + 1 < num_reads_parsed;
+    if (!behind and (num_reads_parsed >= read_index->num_reads()
+                     or entry_offset < read_index->read_offset(num_reads_parsed) + min_seek_distance))
+        return false;
+
+    num_reads_parsed = id;
+    name.clear();
+    read.clear();
+    line.clear();
+    discard_buffer();
+    if (gzipped) {
+        inflater.reset(new GzipInflater(fastaq_file, *checkpoint, read_index->window(*checkpoint)));
+        instream.ignore(offset - entry_offset);
+    } else {
+        fastaq_file.seekg(offset);
+    }
+    return true;
+}
+
+// Drops what the stream has buffered, so that reading carries on from wherever the file or inflater is moved to next
+void FastaqHandler::discard_buffer() {
+    const auto num_buffered = inbuf.in_avail();
+    if (num_buffered > 0) {
+        // rather than instream.ignore, which refills the buffer once it is empty
+        std::vector<char> buffered(num_buffered);
+        inbuf.sgetn(buffered.data(), num_buffered);
+    }
+    instream.clear();
+    fastaq_file.clear();
+}
+
 void FastaqHandler::get_id(const uint32_t &id) {
     const uint32_t one_based_id = id + 1;
-    if (one_based_id < num_reads_parsed) {
+    if (seek(id)) {
+        assert(num_reads_parsed == id);
+    } else if (one_based_id < num_reads_parsed) {
         BOOST_LOG_TRIVIAL(warning) << "restart buffer as have id " << num_reads_parsed << " and want id "
                                    << one_based_id << " (" << id << ") with 0-based indexing.";
         num_reads_parsed = 0;
@@ -134,15 +203,11 @@ void FastaqHandler::get_id(const uint32_t &id) {
         assert(read.empty());
         assert(line.empty());
 
-        instream.ignore(std::numeric_limits<std::streamsize>::max());
+        discard_buffer();
         fastaq_file.seekg(0, fastaq_file.beg);
-        instream.clear();
-        inbuf.pop();
         if (gzipped) {
-            inbuf.pop();
-            inbuf.push(boost::iostreams::gzip_decompressor());
+            inflater.reset(new GzipInflater(fastaq_file));
         }
-        inbuf.push(fastaq_file);
     }
 
     while (id > 1 and num_reads_parsed < id) {
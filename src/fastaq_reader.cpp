@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <boost/log/trivial.hpp>
+#include "fastaq_reader.h"
+
+
+FastaqReader::FastaqReader(const std::string &filepath, ReadIndexBuilder *index) : filepath(filepath), index(index),
+                                                                                    chunks(max_queued),
+                                                                                    batches(max_queued) {
+    BOOST_LOG_TRIVIAL(debug) << "Open fastaq file " << filepath;
+    file.open(filepath, std::ios::binary);
+    if (not file.is_open()) {
+        std::cerr << "Unable to open fastaq file " << filepath << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    if (index != nullptr) {
+        index->gzipped = is_gzipped();
+        index->read_offsets.clear();
+        index->checkpoints.clear();
+        index->windows.clear();
+    }
+    decompressor = std::thread(&FastaqReader::decompress, this);
+    parser = std::thread(&FastaqReader::parse, this);
+}
+
+FastaqReader::~FastaqReader() {
+    close();
+}
+
+void FastaqReader::close() {
+    batches.close();
+    chunks.close();
+    if (parser.joinable())
+        parser.join();
+    if (decompressor.joinable())
+        decompressor.join();
+}
+
+bool FastaqReader::next_batch(std::vector<FastaqRecord> &records) {
+    if (batches.pop(records))
+        return true;
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if (error != nullptr)
+        std::rethrow_exception(error);
+    records.clear();
+    return false;
+}
+
+void FastaqReader::set_error(std::exception_ptr e) {
+    std::lock_guard<std::mutex> lock(error_mutex);
+    error = e;
+}
+
+bool FastaqReader::is_gzipped() const {
+    return filepath.length() >= 2 and filepath.substr(filepath.length() - 2) == "gz";
+}
+
+void FastaqReader::decompress() {
+    try {
+        std::unique_ptr<GzipInflater> inflater;
+        if (is_gzipped())
+            inflater.reset(new GzipInflater(file, index));
+        while (true) {
+            std::string chunk(chunk_size, '\0');
+            if (inflater != nullptr) {
+                chunk.resize(inflater->read(&chunk[0], chunk.size()));
+            } else {
+                file.read(&chunk[0], chunk.size());
+                chunk.resize(file.gcount());
+            }
+            if (chunk.empty() or !chunks.push(std::move(chunk)))
+                break;
+        }
+    } catch (...) {
+        BOOST_LOG_TRIVIAL(error) << "Problem reading fastaq file " << filepath;
+        set_error(std::current_exception());
+    }
+    chunks.close();
+}
+
+// Parses lines as FastaqHandler does, except that the quality of a FASTQ record may run over several lines, up to the
+// length of its sequence, as long as those after the first do not start like a name. Records with no sequence are
+// kept, so that ids match FastaqHandler::get_id.
+void FastaqReader::parse() {
+    try {
+        std::vector<FastaqRecord> batch;
+        size_t batch_bases = 0;
+        FastaqRecord record;
+        bool in_record = false;
+        uint32_t num_records = 0;
+        size_t quality_left = 0; //bases of the FASTQ record whose quality is yet to be skipped
+        bool first_quality_line = false;
+        std::string text, chunk; //text is the unfinished last line of the previous chunk, then this chunk
+        uint64_t text_offset = 0; //of text in the decompressed file
+
+        // false if the reader was closed before the batch could be handed over
+        auto end_record = [&]() -> bool {
+            if (!in_record)
+                return true;
+            in_record = false;
+            batch_bases += record.seq.size();
+            batch.push_back(std::move(record));
+            record = FastaqRecord();
+            if (batch.size() < max_batch_records and batch_bases < max_batch_bases)
+                return true;
+            batch_bases = 0;
+            if (!batches.push(std::move(batch)))
+                return false;
+            batch = std::vector<FastaqRecord>();
+            return true;
+        };
+
+        auto parse_line = [&](const char *start, const char *end) -> bool {
+            if (start != end and *(end - 1) == '\r')
+                --end;
+            if (quality_left > 0) {
+                if (first_quality_line or (start != end and *start != '>' and *start != '@')) {
+                    first_quality_line = false;
+                    quality_left -= std::min(quality_left, size_t(end - start));
+                    return true;
+                }
+                quality_left = 0;
+            }
+            if (start == end) {
+                return true;
+            } else if (*start == '>' or *start == '@') {
+                if (!end_record())
+                    return false;
+                record.id = num_records++;
+                if (index != nullptr)
+                    index->read_offsets.push_back(text_offset + (start - text.data()));
+                record.name.assign(start + 1, end);
+                in_record = true;
+            } else if (*start == '+') {
+                quality_left = record.seq.size();
+                first_quality_line = true;
+            } else if (in_record) {
+                record.seq.append(start, end);
+            }
+            return true;
+        };
+
+        bool stopped = false;
+        while (!stopped and chunks.pop(chunk)) {
+            // what is left of the text from before has no newline, so a line over many chunks is only scanned once
+            size_t scan_from = text.size();
+            if (text.empty())
+                text.swap(chunk);
+            else
+                text.append(chunk);
+            size_t start = 0, newline;
+            while ((newline = text.find('\n', scan_from)) != std::string::npos) {
+                if (!parse_line(text.data() + start, text.data() + newline)) {
+                    stopped = true;
+                    break;
+                }
+                start = scan_from = newline + 1;
+            }
+            text.erase(0, start);
+            text_offset += start;
+        }
+        if (!stopped and parse_line(text.data(), text.data() + text.size()) and end_record() and !batch.empty())
+            batches.push(std::move(batch));
+    } catch (...) {
+        set_error(std::current_exception());
+    }
+    chunks.close();
+    batches.close();
+}
@@ -13,19 +13,35 @@
 
 int pandora_get_vcf_ref(int argc, char *argv[]) // the "pandora walk" comand
 {
-    if (argc != 3 and argc != 2) {
-        fprintf(stderr, "Usage: pandora get_vcf_ref <in_prg.fa> <seq.fa>\n");
+    // options may come before or between the arguments
+    std::vector<std::string> args;
+    uint32_t threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-t") || (arg == "--threads")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                threads = (unsigned) atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--threads option requires one argument." << std::endl;
+                return 1;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.size() != 2 and args.size() != 1) {
+        fprintf(stderr, "Usage: pandora get_vcf_ref [-t <threads>] <in_prg.fa> [<seq.fa>]\n");
         return 1;
     }
 
     // load prgs
     std::vector<std::shared_ptr<LocalPRG>> prgs;
-    read_prg_file(prgs, argv[1]);
+    read_prg_file(prgs, args[0], 0, threads);
 
     // create fasta
     Fastaq fa(true, false);
 
-    if (argc == 2) {
+    if (args.size() == 1) {
         for (const auto &prg_ptr: prgs) {
             std::vector<LocalNodePtr> npath;
             npath = prg_ptr->prg.top_path();
@@ -34,7 +50,7 @@ int pandora_get_vcf_ref(int argc, char *argv[]) // the "pandora walk" comand
     } else {
         std::vector<LocalNodePtr> npath;
         std::string read_string;
-        FastaqHandler readfile(argv[2]);
+        FastaqHandler readfile(args[1]);
         bool found;
 
         for (const auto &prg_ptr: prgs) {
@@ -60,7 +76,7 @@ int pandora_get_vcf_ref(int argc, char *argv[]) // the "pandora walk" comand
         }
     }
 
-    std::string prg_file(argv[1]);
+    std::string prg_file(args[0]);
     fa.save(prg_file + ".vcf_ref.fa.gz");
 
     return 0;
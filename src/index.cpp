@@ -3,13 +3,197 @@
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
+#include <cassert>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
 
 #include <boost/log/trivial.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include "minirecord.h"
 #include "index.h"
 #include "localPRG.h"
+#include "kmergraph_store.h"
 
+// Binary index layout. Every section is a flat array of fixed size entries starting on an 8 byte
+// boundary, so a memory mapped file can be read in place without parsing:
+//   IndexFileHeader
+//   uint64_t keys[num_keys]                minimizer hashes in increasing order
+//   uint64_t offsets[num_keys + 1]         records of keys[i] are records[offsets[i]..offsets[i+1])
+//   IndexFileRecord records[num_records]
+//   IndexFileInterval intervals[num_intervals]   the paths of all records, back to back
+//   uint32_t min_path_lengths[num_prgs]    Index::min_path_lengths, padded to 8 bytes
+// Integers are stored in host byte order.
+namespace {
+    const char index_magic[8] = {'P', 'A', 'N', 'D', 'I', 'D', 'X', '\0'};
+    const uint32_t index_version = 3;
+
+    struct IndexFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size; //sizeof(IndexFileRecord) of the writer
+        uint64_t num_keys;
+        uint64_t num_records;
+        uint64_t num_intervals;
+        uint64_t num_prgs; //Index::num_prgs, so that PRGs without minimizers are known to be indexed
+    };
+
+    struct IndexFileRecord {
+        uint64_t path_offset; //position of the first interval of the path in the intervals section
+        uint32_t path_size;
+        uint32_t prg_id;
+        uint32_t knode_id;
+        uint32_t strand;
+    };
+
+    struct IndexFileInterval {
+        uint32_t start;
+        uint32_t length;
+    };
+
+    static_assert(sizeof(IndexFileHeader) == 48, "unexpected padding in IndexFileHeader");
+    static_assert(sizeof(IndexFileRecord) == 24, "unexpected padding in IndexFileRecord");
+    static_assert(sizeof(IndexFileInterval) == 8, "unexpected padding in IndexFileInterval");
+
+    bool is_binary_index(const std::string &indexfile) {
+        char magic[sizeof(index_magic)];
+        std::ifstream handle(indexfile, std::ios::binary);
+        handle.read(magic, sizeof(magic));
+        return handle.gcount() == sizeof(magic) and std::memcmp(magic, index_magic, sizeof(magic)) == 0;
+    }
+
+    uint64_t min_path_lengths_size(const uint64_t num_prgs) {
+        return (num_prgs + 1) / 2 * sizeof(uint64_t);
+    }
+
+    // a binary index file mapped into memory, with pointers to its sections
+    struct IndexFileView {
+        boost::iostreams::mapped_file_source file;
+        IndexFileHeader header;
+        const uint64_t *keys;
+        const uint64_t *offsets;
+        const IndexFileRecord *records;
+        const IndexFileInterval *intervals;
+        const uint32_t *min_path_lengths;
+
+        explicit IndexFileView(const std::string &indexfile) : file(indexfile) {
+            const char *data = file.data();
+            const auto file_size = file.size();
+
+            if (file_size < sizeof(header)) {
+                BOOST_LOG_TRIVIAL(error) << "Index file " << indexfile << " is truncated";
+                exit(1);
+            }
+            std::memcpy(&header, data, sizeof(header));
+            if (header.version != index_version or header.record_size != sizeof(IndexFileRecord)) {
+                BOOST_LOG_TRIVIAL(error) << "Index file " << indexfile << " has format version " << header.version
+                                         << " but this pandora reads version " << index_version
+                                         << ". Please rerun pandora index";
+                exit(1);
+            }
+            const uint64_t expected_size = sizeof(header)
+                                           + header.num_keys * sizeof(uint64_t)
+                                           + (header.num_keys + 1) * sizeof(uint64_t)
+                                           + header.num_records * sizeof(IndexFileRecord)
+                                           + header.num_intervals * sizeof(IndexFileInterval)
+                                           + min_path_lengths_size(header.num_prgs);
+            if (file_size != expected_size) {
+                BOOST_LOG_TRIVIAL(error) << "Index file " << indexfile << " has size " << file_size
+                                         << " but its header implies " << expected_size << ". Is it truncated?";
+                exit(1);
+            }
+
+            keys = reinterpret_cast<const uint64_t *>(data + sizeof(header));
+            offsets = keys + header.num_keys;
+            records = reinterpret_cast<const IndexFileRecord *>(offsets + header.num_keys + 1);
+            intervals = reinterpret_cast<const IndexFileInterval *>(records + header.num_records);
+            min_path_lengths = reinterpret_cast<const uint32_t *>(intervals + header.num_intervals);
+        }
+    };
+
+    IndexFileHeader make_header(const uint64_t num_keys, const uint64_t num_records, const uint64_t num_intervals,
+                                const uint64_t num_prgs) {
+        IndexFileHeader header;
+        std::memcpy(header.magic, index_magic, sizeof(index_magic));
+        header.version = index_version;
+        header.record_size = sizeof(IndexFileRecord);
+        header.num_keys = num_keys;
+        header.num_records = num_records;
+        header.num_intervals = num_intervals;
+        header.num_prgs = num_prgs;
+        return header;
+    }
+
+    template<typename T>
+    void write_binary(std::ofstream &handle, const T &value) {
+        handle.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void write_min_path_lengths(std::ofstream &handle, std::vector<uint32_t> min_path_lengths, const uint64_t num_prgs) {
+        min_path_lengths.resize(min_path_lengths_size(num_prgs) / sizeof(uint32_t), 0);
+        handle.write(reinterpret_cast<const char *>(min_path_lengths.data()), min_path_lengths.size() * sizeof(uint32_t));
+    }
+
+    MiniRecord to_minirecord(const IndexFileRecord &record, const IndexFileInterval *intervals) {
+        prg::Path path;
+        path.path.reserve(record.path_size);
+        for (auto l = record.path_offset; l != record.path_offset + record.path_size; ++l)
+            path.path.emplace_back(intervals[l].start, intervals[l].start + intervals[l].length);
+        return MiniRecord(record.prg_id, path, record.knode_id, record.strand != 0);
+    }
+
+    // keeps the largest known length of each PRG, 0 meaning unknown
+    void merge_min_path_lengths(std::vector<uint32_t> &min_path_lengths, const uint32_t *other, const uint64_t num_other) {
+        if (min_path_lengths.size() < num_other)
+            min_path_lengths.resize(num_other, 0);
+        for (uint64_t i = 0; i != num_other; ++i)
+            min_path_lengths[i] = std::max(min_path_lengths[i], other[i]);
+    }
+}
+
+// A binary index file used in place as the frozen table of an Index. The records of a key are made into MiniRecords,
+// interning their paths, the first time the key is found, which may be from several threads at once.
+struct MappedIndexFile {
+    static const uint8_t unmade = 0, making = 1, made = 2;
+
+    IndexFileView view;
+    std::unique_ptr<std::atomic<uint8_t>[]> states; //of the records of each key
+    MiniRecord *records; //allocated for all records, each constructed once its key is made
+
+    explicit MappedIndexFile(const std::string &indexfile)
+            : view(indexfile), states(new std::atomic<uint8_t>[view.header.num_keys]()),
+              records(static_cast<MiniRecord *>(::operator new(view.header.num_records * sizeof(MiniRecord)))) {}
+
+    ~MappedIndexFile() {
+        for (uint64_t i = 0; i != view.header.num_keys; ++i) {
+            if (states[i].load(std::memory_order_relaxed) == made) {
+                for (auto j = view.offsets[i]; j != view.offsets[i + 1]; ++j)
+                    records[j].~MiniRecord();
+            }
+        }
+        ::operator delete(records);
+    }
+
+    MiniRecordSpan find(const uint64_t i) {
+        auto &state = states[i];
+        if (state.load(std::memory_order_acquire) != made) {
+            uint8_t expected = unmade;
+            if (state.compare_exchange_strong(expected, making, std::memory_order_acquire)) {
+                for (auto j = view.offsets[i]; j != view.offsets[i + 1]; ++j)
+                    new(records + j) MiniRecord(to_minirecord(view.records[j], view.intervals));
+                state.store(made, std::memory_order_release);
+            } else {
+                while (state.load(std::memory_order_acquire) != made)
+                    std::this_thread::yield();
+            }
+        }
+        return {records + view.offsets[i], records + view.offsets[i + 1]};
+    }
+};
 
 Index::Index() = default;
 
@@ -20,27 +204,342 @@ Index::~Index() {
 void Index::add_record(const uint64_t kmer, const uint32_t prg_id, const prg::Path path, const uint32_t knode_id,
                        const bool strand) {
     //cout << "Add kmer " << kmer << " id, path, strand " << prg_id << ", " << path << ", " << strand << endl;
+    if (frozen)
+        thaw();
+    num_prgs = std::max(num_prgs, prg_id + 1);
     auto it = minhash.find(kmer); //checks if kmer is in minhash
     if (it == minhash.end()) { //no
-        auto *newv = new std::vector<MiniRecord>; //get a new vector of MiniRecords - TODO: is this a memory leak?
-        newv->reserve(20);
+        auto *newv = new std::vector<MiniRecord>; //get a new vector of MiniRecords, deleted by clear() or freeze()
         newv->emplace_back(MiniRecord(prg_id, path, knode_id, strand));
         minhash.insert(std::pair<uint64_t, std::vector<MiniRecord> *>(kmer, newv));
         //cout << "New minhash size: " << minhash.size() << endl; 
     } else { //yes
         MiniRecord mr(prg_id, path, knode_id, strand); //create a new MiniRecord from this minimizer kmer
-        if (find(it->second->begin(), it->second->end(), mr) == it->second->end()) { //checks if minimizer kmer is in the vector indexed by minhash[kmer]
+        if (std::find(it->second->begin(), it->second->end(), mr) == it->second->end()) { //checks if minimizer kmer is in the vector indexed by minhash[kmer]
             it->second->push_back(mr); //no, add it
         }
         //cout << "New minhash entry for  kmer " << kmer << endl;
     }
 }
 
+// moves the records of other into this index, in order and skipping duplicates as add_record does, so merging
+// the indexes of consecutive PRGs gives the same index as adding all their records to one
+void Index::merge(Index &other) {
+    if (frozen)
+        thaw();
+    if (other.frozen)
+        other.thaw();
+    num_prgs = std::max(num_prgs, other.num_prgs);
+    merge_min_path_lengths(min_path_lengths, other.min_path_lengths.data(), other.min_path_lengths.size());
+    for (auto &entry : other.minhash) {
+        auto it = minhash.find(entry.first);
+        if (it == minhash.end()) {
+            minhash.insert(entry);
+            entry.second = nullptr;
+            continue;
+        }
+        auto &vmr = *it->second;
+        const auto num_existing = vmr.size();
+        for (auto &record : *entry.second) {
+            if (std::find(vmr.begin(), vmr.begin() + num_existing, record) == vmr.begin() + num_existing)
+                vmr.push_back(std::move(record));
+        }
+    }
+    other.clear();
+}
+
+void Index::freeze() {
+    if (frozen)
+        return;
+
+    keys.clear();
+    keys.reserve(minhash.size());
+    size_t n = 0;
+    for (const auto &entry : minhash) {
+        keys.push_back(entry.first);
+        n += entry.second->size();
+    }
+    std::sort(keys.begin(), keys.end());
+
+    offsets.clear();
+    offsets.reserve(keys.size() + 1);
+    offsets.push_back(0);
+    records.clear();
+    records.reserve(n);
+    for (const auto &key : keys) {
+        auto *vmr = minhash.at(key);
+        std::move(vmr->begin(), vmr->end(), std::back_inserter(records));
+        offsets.push_back(records.size());
+        delete vmr;
+    }
+    std::unordered_map<uint64_t, std::vector<MiniRecord> *>().swap(minhash); //release the buckets too
+
+    frozen = true;
+    build_buckets();
+}
+
+void Index::thaw() {
+    unmap();
+    for (size_t i = 0; i != keys.size(); ++i) {
+        auto *vmr = new std::vector<MiniRecord>(std::make_move_iterator(records.begin() + offsets[i]),
+                                                std::make_move_iterator(records.begin() + offsets[i + 1]));
+        minhash.insert(std::make_pair(keys[i], vmr));
+    }
+    keys.clear();
+    offsets.clear();
+    records.clear();
+    buckets.clear();
+    frozen = false;
+}
+
+void Index::build_buckets() {
+    assert(frozen);
+    // keys are hashes of k-mers and so are close to uniform below 2^(2k), bucket on their top bits
+    buckets.clear();
+    bucket_shift = 0;
+    const auto *table = table_keys();
+    const auto size = num_keys();
+    if (size == 0)
+        return;
+
+    uint32_t key_bits = 0, bucket_bits = 0;
+    while (key_bits < 64 and (table[size - 1] >> key_bits) != 0)
+        ++key_bits;
+    while (bucket_bits < key_bits and bucket_bits < 30 and (uint64_t(1) << (bucket_bits + 2)) < size)
+        ++bucket_bits; //aim for a few keys per bucket
+    bucket_shift = key_bits - bucket_bits;
+
+    const uint64_t num_buckets = uint64_t(1) << bucket_bits;
+    buckets.reserve(num_buckets + 1);
+    uint64_t i = 0;
+    for (uint64_t b = 0; b != num_buckets; ++b) {
+        buckets.push_back(i);
+        while (i != size and bucket(table[i]) == b)
+            ++i;
+    }
+    buckets.push_back(size);
+}
+
+const uint64_t *Index::table_keys() const {
+    return mapped != nullptr ? mapped->view.keys : keys.data();
+}
+
+const uint64_t *Index::table_offsets() const {
+    return mapped != nullptr ? mapped->view.offsets : offsets.data();
+}
+
+MiniRecordSpan Index::table_records(const uint64_t i) const {
+    if (mapped != nullptr)
+        return mapped->find(i);
+    return {records.data() + offsets[i], records.data() + offsets[i + 1]};
+}
+
+void Index::unmap() {
+    if (mapped == nullptr)
+        return;
+    const auto &header = mapped->view.header;
+    keys.assign(mapped->view.keys, mapped->view.keys + header.num_keys);
+    offsets.assign(mapped->view.offsets, mapped->view.offsets + header.num_keys + 1);
+    records.clear();
+    records.reserve(header.num_records);
+    for (uint64_t i = 0; i != header.num_keys; ++i) {
+        const auto span = mapped->find(i);
+        records.insert(records.end(), span.begin(), span.end());
+    }
+    mapped.reset();
+}
+
+uint64_t Index::bucket(const uint64_t kmer) const {
+    return bucket_shift < 64 ? kmer >> bucket_shift : 0;
+}
+
+bool Index::is_frozen() const {
+    return frozen;
+}
+
+MiniRecordSpan Index::find(const uint64_t kmer) const {
+    if (!frozen) {
+        const auto it = minhash.find(kmer);
+        if (it == minhash.end() or it->second->empty())
+            return {nullptr, nullptr};
+        return {it->second->data(), it->second->data() + it->second->size()};
+    }
+
+    if (num_keys() == 0)
+        return {nullptr, nullptr};
+    const auto b = bucket(kmer);
+    if (b + 1 >= buckets.size())
+        return {nullptr, nullptr};
+    const auto *table = table_keys();
+    const auto first = table + buckets[b];
+    const auto last = table + buckets[b + 1];
+    const auto it = std::lower_bound(first, last, kmer);
+    if (it == last or *it != kmer)
+        return {nullptr, nullptr};
+    return table_records(it - table);
+}
+
+// Looks up kmers a batch at a time, stepping the whole batch through the bucket table, the keys and the offsets in turn
+// and prefetching what the next step reads, so that the cache misses of a batch overlap rather than follow each other
+void Index::find(const std::vector<uint64_t> &kmers, std::vector<MiniRecordSpan> &spans) const {
+    spans.resize(kmers.size());
+    if (!frozen or num_keys() == 0) {
+        for (size_t i = 0; i != kmers.size(); ++i)
+            spans[i] = find(kmers[i]);
+        return;
+    }
+
+    const auto *table = table_keys();
+    const auto *table_offsets = this->table_offsets();
+    const size_t batch_size = 16;
+    const uint64_t not_found = std::numeric_limits<uint64_t>::max();
+    uint64_t positions[batch_size];
+    for (size_t start = 0; start < kmers.size(); start += batch_size) {
+        const size_t n = std::min(batch_size, kmers.size() - start);
+        for (size_t j = 0; j != n; ++j) {
+            positions[j] = bucket(kmers[start + j]);
+            if (positions[j] + 1 < buckets.size())
+                __builtin_prefetch(&buckets[positions[j]]);
+        }
+        for (size_t j = 0; j != n; ++j) {
+            if (positions[j] + 1 < buckets.size()) {
+                __builtin_prefetch(&table[buckets[positions[j]]]);
+            } else {
+                positions[j] = not_found;
+            }
+        }
+        for (size_t j = 0; j != n; ++j) {
+            if (positions[j] == not_found)
+                continue;
+            const auto first = table + buckets[positions[j]];
+            const auto last = table + buckets[positions[j] + 1];
+            const auto it = std::lower_bound(first, last, kmers[start + j]);
+            if (it == last or *it != kmers[start + j]) {
+                positions[j] = not_found;
+            } else {
+                positions[j] = it - table;
+                __builtin_prefetch(&table_offsets[positions[j]]);
+            }
+        }
+        for (size_t j = 0; j != n; ++j) {
+            if (positions[j] == not_found) {
+                spans[start + j] = {nullptr, nullptr};
+            } else {
+                spans[start + j] = table_records(positions[j]);
+                __builtin_prefetch(spans[start + j].first);
+            }
+        }
+    }
+}
+
+// Merges kmers, which are in increasing order, with the sorted keys. Galloping ahead in the keys from the last match
+// makes this a sequential scan when the kmers are dense in the keys, and a few probes per kmer when they are sparse.
+void Index::find_sorted(const std::vector<uint64_t> &kmers, std::vector<MiniRecordSpan> &spans) const {
+    if (!frozen) {
+        find(kmers, spans);
+        return;
+    }
+
+    spans.resize(kmers.size());
+    const auto *table = table_keys();
+    const auto size = num_keys();
+    size_t i = 0; //keys before i are smaller than the current kmer
+    for (size_t j = 0; j != kmers.size(); ++j) {
+        assert(j == 0 or kmers[j - 1] <= kmers[j]);
+        size_t probe = i, step = 1;
+        while (probe < size and table[probe] < kmers[j]) {
+            i = probe + 1;
+            probe += step;
+            step <<= 1;
+        }
+        i = std::lower_bound(table + i, table + std::min(probe + 1, size), kmers[j]) - table;
+        if (i != size and table[i] == kmers[j]) {
+            spans[j] = table_records(i);
+        } else {
+            spans[j] = {nullptr, nullptr};
+        }
+    }
+}
+
+size_t Index::num_keys() const {
+    if (!frozen)
+        return minhash.size();
+    return mapped != nullptr ? mapped->view.header.num_keys : keys.size();
+}
+
+size_t Index::num_records() const {
+    if (frozen)
+        return table_offsets()[num_keys()];
+    size_t n = 0;
+    for (const auto &entry : minhash)
+        n += entry.second->size();
+    return n;
+}
+
+// Like minimap2 -f, max_freq >= 1 masks the minimizers with more than max_freq records and 0 < max_freq < 1 masks
+// the max_freq fraction of distinct minimizers with the most records. The number of records of each minimizer is
+// its number of occurrences in the PRGs, recorded by the offsets of the frozen table.
+void Index::mask_frequent_minimizers(const float max_freq) {
+    freeze();
+    max_occurrences = std::numeric_limits<uint32_t>::max();
+    const auto size = num_keys();
+    const auto *offsets = table_offsets();
+    if (max_freq <= 0 or size == 0)
+        return;
+
+    if (max_freq >= 1) {
+        max_occurrences = (uint32_t) max_freq;
+    } else {
+        std::vector<uint64_t> occurrences;
+        occurrences.reserve(size);
+        for (size_t i = 0; i != size; ++i)
+            occurrences.push_back(offsets[i + 1] - offsets[i]);
+        const auto nth = occurrences.begin() + std::min(occurrences.size() - 1, size_t((1 - max_freq) * occurrences.size()));
+        std::nth_element(occurrences.begin(), nth, occurrences.end());
+        max_occurrences = (uint32_t) std::min(*nth, (uint64_t) std::numeric_limits<uint32_t>::max());
+    }
+
+    uint64_t num_masked_keys = 0, num_masked_records = 0;
+    for (size_t i = 0; i != size; ++i) {
+        if (offsets[i + 1] - offsets[i] > max_occurrences) {
+            num_masked_keys += 1;
+            num_masked_records += offsets[i + 1] - offsets[i];
+        }
+    }
+    BOOST_LOG_TRIVIAL(info) << "Masked " << num_masked_keys << " of " << size << " minimizers which occur more than "
+                            << max_occurrences << " times in the index, covering " << num_masked_records << " of "
+                            << offsets[size] << " records";
+}
+
+bool Index::is_masked(const MiniRecordSpan &span) const {
+    return span.size() > max_occurrences;
+}
+
+std::vector<uint64_t> Index::sorted_keys() const {
+    if (frozen)
+        return std::vector<uint64_t>(table_keys(), table_keys() + num_keys());
+    std::vector<uint64_t> result;
+    result.reserve(minhash.size());
+    for (const auto &entry : minhash)
+        result.push_back(entry.first);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
 void Index::clear() {
     for (auto it = minhash.begin(); it != minhash.end();) {
         delete it->second;
         it = minhash.erase(it);
     }
+    std::vector<uint64_t>().swap(keys);
+    std::vector<uint64_t>().swap(offsets);
+    std::vector<MiniRecord>().swap(records);
+    mapped.reset();
+    std::vector<uint64_t>().swap(buckets);
+    bucket_shift = 0;
+    frozen = false;
+    num_prgs = 0;
+    std::vector<uint32_t>().swap(min_path_lengths);
 }
 
 void Index::save(const std::string &prgfile, uint32_t w, uint32_t k) {
@@ -50,21 +549,69 @@ void Index::save(const std::string &prgfile, uint32_t w, uint32_t k) {
 
 void Index::save(const std::string &indexfile) {
     BOOST_LOG_TRIVIAL(debug) << "Saving index to " << indexfile;
+    freeze();
+    unmap(); //which may be the file being written
+    uint64_t num_intervals = 0;
+    for (const auto &record : records)
+        num_intervals += record.path().path.size();
+    const auto header = make_header(keys.size(), records.size(), num_intervals, num_prgs);
+
+    std::ofstream handle(indexfile, std::ios::binary);
+    if (!handle.is_open()) {
+        BOOST_LOG_TRIVIAL(error) << "Unable to open index file " << indexfile << " for writing";
+        exit(1);
+    }
+    write_binary(handle, header);
+    handle.write(reinterpret_cast<const char *>(keys.data()), keys.size() * sizeof(uint64_t));
+    if (offsets.empty()) {
+        write_binary(handle, uint64_t(0));
+    } else {
+        handle.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    }
+
+    IndexFileRecord file_record;
+    file_record.path_offset = 0;
+    for (const auto &record : records) {
+        file_record.path_size = record.path().path.size();
+        file_record.prg_id = record.prg_id;
+        file_record.knode_id = record.knode_id;
+        file_record.strand = record.strand;
+        write_binary(handle, file_record);
+        file_record.path_offset += file_record.path_size;
+    }
+
+    IndexFileInterval file_interval;
+    for (const auto &record : records) {
+        for (const auto &interval : record.path().path) {
+            file_interval.start = interval.start;
+            file_interval.length = interval.length;
+            write_binary(handle, file_interval);
+        }
+    }
+    write_min_path_lengths(handle, min_path_lengths, num_prgs);
+    handle.close();
+    BOOST_LOG_TRIVIAL(debug) << "Finished saving " << keys.size() << " entries to file";
+}
+
+void Index::save_text(const std::string &indexfile) {
+    BOOST_LOG_TRIVIAL(debug) << "Saving index in text format to " << indexfile;
+    freeze();
+    unmap();
     std::ofstream handle;
     handle.open(indexfile);
 
-    handle << minhash.size() << std::endl;
+    handle << keys.size() << std::endl;
 
-    for (auto &it : minhash) {
-        handle << it.first << "\t" << it.second->size();
-        for (uint32_t j = 0; j != it.second->size(); ++j) {
-            handle << "\t" << (*(it.second))[j];
+    for (size_t i = 0; i != keys.size(); ++i) {
+        handle << keys[i] << "\t" << offsets[i + 1] - offsets[i];
+        for (auto j = offsets[i]; j != offsets[i + 1]; ++j) {
+            handle << "\t" << records[j];
         }
         handle << std::endl;
 
     }
     handle.close();
-    BOOST_LOG_TRIVIAL(debug) << "Finished saving " << minhash.size() << " entries to file";
+    BOOST_LOG_TRIVIAL(debug) << "Finished saving " << keys.size() << " entries to file";
 }
 
 void Index::load(const std::string &prgfile, uint32_t w, uint32_t k) {
@@ -75,12 +622,65 @@ void Index::load(const std::string &prgfile, uint32_t w, uint32_t k) {
 void Index::load(const std::string &indexfile) {
     BOOST_LOG_TRIVIAL(debug) << "Loading index";
     BOOST_LOG_TRIVIAL(debug) << "File is " << indexfile;
+    if (!fs::exists(indexfile)) {
+        BOOST_LOG_TRIVIAL(warning) << "Unable to open index file " << indexfile << ". Does it exist? Have you run pandora index?";
+        exit(1);
+    }
+
+    if (is_binary_index(indexfile)) {
+        load_binary(indexfile);
+    } else {
+        const bool was_empty = num_keys() == 0;
+        load_text(indexfile);
+        if (was_empty)
+            freeze();
+    }
+
+    if (num_keys() <= 1){
+        BOOST_LOG_TRIVIAL(debug) << "Was this file empty?! Index now contains a trivial " << num_keys() << " entries";
+    } else {
+        BOOST_LOG_TRIVIAL(debug) << "Finished loading file. Index now contains " << num_keys() << " entries";
+    }
+}
+
+void Index::load_binary(const std::string &indexfile) {
+    if (num_keys() == 0) { //the file already has the layout of the frozen table, so is used in place
+        clear();
+        mapped = std::make_shared<MappedIndexFile>(indexfile);
+        frozen = true;
+        build_buckets();
+        const auto &view = mapped->view;
+        num_prgs = view.header.num_prgs;
+        min_path_lengths.assign(view.min_path_lengths, view.min_path_lengths + view.header.num_prgs);
+        return;
+    }
+
+    const IndexFileView view(indexfile);
+    const auto &header = view.header;
+    if (frozen)
+        thaw();
+    num_prgs = std::max(num_prgs, uint32_t(header.num_prgs));
+    merge_min_path_lengths(min_path_lengths, view.min_path_lengths, header.num_prgs);
+    minhash.reserve(minhash.size() + header.num_keys);
+    for (uint64_t i = 0; i != header.num_keys; ++i) {
+        auto &vmr = minhash[view.keys[i]];
+        if (vmr == nullptr)
+            vmr = new std::vector<MiniRecord>;
+        vmr->reserve(vmr->size() + view.offsets[i + 1] - view.offsets[i]);
+        for (auto j = view.offsets[i]; j != view.offsets[i + 1]; ++j)
+            vmr->push_back(to_minirecord(view.records[j], view.intervals));
+    }
+}
+
+void Index::load_text(const std::string &indexfile) {
     uint64_t key;
     size_t size;
     int c;
     MiniRecord mr;
     bool first = true;
 
+    if (frozen)
+        thaw();
     std::ifstream myfile(indexfile);
     if (myfile.is_open()) {
         while (myfile.good()) {
@@ -94,20 +694,17 @@ void Index::load(const std::string &indexfile) {
                 myfile >> key;
                 myfile.ignore(1, '\t');
                 myfile >> size;
-                auto *vmr = new std::vector<MiniRecord>;
-                if (minhash.find(key) != minhash.end()) {
-                    vmr = minhash[key];
-                    vmr->reserve(vmr->size() + size);
-                } else {
-                    vmr->reserve(size);
-                    minhash[key] = vmr;
-                }
+                auto &vmr = minhash[key];
+                if (vmr == nullptr)
+                    vmr = new std::vector<MiniRecord>;
+                vmr->reserve(vmr->size() + size);
                 myfile.ignore(1, '\t');
             } else if (c == EOF) {
                 break;
             } else {
                 myfile >> mr;
                 minhash[key]->push_back(mr);
+                num_prgs = std::max(num_prgs, mr.prg_id + 1); //the text format has no count of PRGs
                 myfile.ignore(1, '\t');
             }
         }
@@ -115,32 +712,20 @@ void Index::load(const std::string &indexfile) {
         BOOST_LOG_TRIVIAL(warning) << "Unable to open index file " << indexfile << ". Does it exist? Have you run pandora index?";
         exit(1);
     }
-
-    if (minhash.size() <= 1){
-        BOOST_LOG_TRIVIAL(debug) << "Was this file empty?! Index now contains a trivial " << minhash.size() << " entries";
-    } else {
-        BOOST_LOG_TRIVIAL(debug) << "Finished loading file. Index now contains " << minhash.size() << " entries";
-    }
 }
 
 bool Index::operator==(const Index &other) const {
-    if (this->minhash.size() != other.minhash.size()){ return false; }
+    if (this->num_keys() != other.num_keys()){ return false; }
 
-    for (const auto &kmer : this->minhash){
-        const auto it = other.minhash.find(kmer.first);
-        if (it == other.minhash.end()) {return false;}
-        const auto& qvecp = it->second;
-        for (const auto &record : *this->minhash.at(kmer.first)){
-            if (std::find(qvecp->begin(), qvecp->end(), record) == qvecp->end()) {return false;}
+    for (const auto &kmer : this->sorted_keys()){
+        const auto these = this->find(kmer);
+        const auto others = other.find(kmer);
+        if (others.empty()) {return false;}
+        for (const auto &record : these){
+            if (std::find(others.begin(), others.end(), record) == others.end()) {return false;}
         }
-    }
-
-    for (const auto &kmer : other.minhash){
-        const auto it = this->minhash.find(kmer.first);
-        if (it == this->minhash.end()) {return false;}
-        const auto& qvecp = it->second;
-        for (const auto &record : *other.minhash.at(kmer.first)){
-            if (std::find(qvecp->begin(), qvecp->end(), record) == qvecp->end()) {return false;}
+        for (const auto &record : others){
+            if (std::find(these.begin(), these.end(), record) == these.end()) {return false;}
         }
     }
     return true;
@@ -151,11 +736,112 @@ bool Index::operator!=(const Index &other) const {
 }
 
 
+// Merges binary index files into outfile in bounded memory. The inputs are memory mapped and their sorted keys
+// k-way merged once per section of the output, which is written sequentially. Records of a key present in several
+// inputs are concatenated in input order, as when the inputs are loaded one after the other into an Index.
+void merge_index_files(const std::vector<std::string> &indexfiles, const std::string &outfile) {
+    std::vector<std::unique_ptr<IndexFileView>> inputs;
+    uint64_t num_records = 0, num_intervals = 0, num_prgs = 0;
+    for (const auto &indexfile : indexfiles) {
+        if (!fs::exists(indexfile)) {
+            BOOST_LOG_TRIVIAL(warning) << "Unable to open index file " << indexfile << ". Does it exist? Have you run pandora index?";
+            exit(1);
+        }
+        if (!is_binary_index(indexfile)) {
+            BOOST_LOG_TRIVIAL(error) << "Index file " << indexfile << " is in text format, which can only be merged in memory";
+            exit(1);
+        }
+        inputs.emplace_back(new IndexFileView(indexfile));
+        num_records += inputs.back()->header.num_records;
+        num_intervals += inputs.back()->header.num_intervals;
+        num_prgs = std::max(num_prgs, inputs.back()->header.num_prgs);
+    }
+
+    // calls f(key, sources) for each distinct key in increasing order, sources being the (input, position of the key
+    // in that input) pairs holding it, in input order
+    typedef std::pair<uint32_t, uint64_t> KeySource;
+    auto for_each_key = [&inputs](const std::function<void(uint64_t, const std::vector<KeySource> &)> &f) {
+        typedef std::pair<uint64_t, uint32_t> HeapEntry; // (key, input)
+        std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+        std::vector<uint64_t> positions(inputs.size(), 0);
+        for (uint32_t i = 0; i != inputs.size(); ++i)
+            if (inputs[i]->header.num_keys > 0)
+                heap.emplace(inputs[i]->keys[0], i);
+
+        std::vector<KeySource> sources;
+        while (!heap.empty()) {
+            const auto key = heap.top().first;
+            sources.clear();
+            while (!heap.empty() and heap.top().first == key) {
+                const auto i = heap.top().second;
+                heap.pop();
+                sources.emplace_back(i, positions[i]);
+                if (++positions[i] != inputs[i]->header.num_keys)
+                    heap.emplace(inputs[i]->keys[positions[i]], i);
+            }
+            f(key, sources);
+        }
+    };
+
+    uint64_t num_keys = 0;
+    for_each_key([&num_keys](uint64_t, const std::vector<KeySource> &) { ++num_keys; });
+    BOOST_LOG_TRIVIAL(debug) << "Merging " << inputs.size() << " indexes with " << num_keys << " distinct keys into " << outfile;
+
+    std::ofstream handle(outfile, std::ios::binary);
+    if (!handle.is_open()) {
+        BOOST_LOG_TRIVIAL(error) << "Unable to open index file " << outfile << " for writing";
+        exit(1);
+    }
+    write_binary(handle, make_header(num_keys, num_records, num_intervals, num_prgs));
+
+    for_each_key([&handle](uint64_t key, const std::vector<KeySource> &) { write_binary(handle, key); });
+
+    uint64_t offset = 0;
+    write_binary(handle, offset);
+    for_each_key([&](uint64_t, const std::vector<KeySource> &sources) {
+        for (const auto &source : sources)
+            offset += inputs[source.first]->offsets[source.second + 1] - inputs[source.first]->offsets[source.second];
+        write_binary(handle, offset);
+    });
+
+    uint64_t path_offset = 0;
+    for_each_key([&](uint64_t, const std::vector<KeySource> &sources) {
+        for (const auto &source : sources) {
+            const auto &input = *inputs[source.first];
+            for (auto j = input.offsets[source.second]; j != input.offsets[source.second + 1]; ++j) {
+                auto record = input.records[j];
+                record.path_offset = path_offset;
+                path_offset += record.path_size;
+                write_binary(handle, record);
+            }
+        }
+    });
+
+    for_each_key([&](uint64_t, const std::vector<KeySource> &sources) {
+        for (const auto &source : sources) {
+            const auto &input = *inputs[source.first];
+            for (auto j = input.offsets[source.second]; j != input.offsets[source.second + 1]; ++j) {
+                const auto &record = input.records[j];
+                handle.write(reinterpret_cast<const char *>(input.intervals + record.path_offset),
+                             record.path_size * sizeof(IndexFileInterval));
+            }
+        }
+    });
+
+    std::vector<uint32_t> min_path_lengths;
+    for (const auto &input : inputs)
+        merge_min_path_lengths(min_path_lengths, input->min_path_lengths, input->header.num_prgs);
+    write_min_path_lengths(handle, min_path_lengths, num_prgs);
+    handle.close();
+    BOOST_LOG_TRIVIAL(debug) << "Finished merging indexes";
+}
+
 void index_prgs(std::vector<std::shared_ptr<LocalPRG>> &prgs, //all PRGs to be indexed
                 std::shared_ptr<Index> &index, //kmer sketch index to be built here
                 const uint32_t w, //window size
                 const uint32_t k, //kmer size
-                const std::string &outdir) {
+                const std::string &outdir, //directory for the kmer graph store
+                const uint32_t threads) {
     BOOST_LOG_TRIVIAL(debug) << "Index PRGs";
     if (prgs.size() == 0)
         return;
@@ -168,19 +854,100 @@ void index_prgs(std::vector<std::shared_ptr<LocalPRG>> &prgs, //all PRGs to be i
     index->minhash.reserve(r);
 
     // now fill index
-    auto dir_num = int(prgs[0]->id/4000); //the number of the dir to put this index
-    for (uint32_t i = 0; i != prgs.size(); ++i) { //for each prg
-        if (i==0 or prgs[i]->id % 4000 == 0) { //deal with a new dir to be created
-            fs::create_directories(outdir + "/" + int_to_string(dir_num + 1));
-            dir_num++;
+    if (threads <= 1) {
+        for (uint32_t i = 0; i != prgs.size(); ++i) {
+            prgs[i]->minimizer_sketch(index, w, k);
+        }
+    } else {
+        // each chunk of consecutive PRGs is sketched into its own shard by whichever thread is free, and the shards
+        // are merged into the index in chunk order so that the result is the same as sketching them one by one
+        const uint32_t chunk_size = std::max(1u, uint32_t(prgs.size() / (threads * 16)));
+        const uint32_t num_chunks = (prgs.size() + chunk_size - 1) / chunk_size;
+        std::vector<std::shared_ptr<Index>> shards(num_chunks);
+        std::atomic<uint32_t> next_chunk(0);
+        std::mutex shards_mutex;
+        std::condition_variable shard_done;
+
+        auto sketch_chunks = [&]() {
+            for (auto c = next_chunk++; c < num_chunks; c = next_chunk++) {
+                auto shard = std::make_shared<Index>();
+                for (auto i = c * chunk_size; i < std::min((c + 1) * chunk_size, (uint32_t) prgs.size()); ++i) {
+                    prgs[i]->minimizer_sketch(shard, w, k);
+                }
+                std::lock_guard<std::mutex> lock(shards_mutex);
+                shards[c] = shard;
+                shard_done.notify_one();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (uint32_t t = 0; t != threads; ++t)
+            workers.emplace_back(sketch_chunks);
+
+        for (uint32_t c = 0; c != num_chunks; ++c) {
+            std::shared_ptr<Index> shard;
+            {
+                std::unique_lock<std::mutex> lock(shards_mutex);
+                shard_done.wait(lock, [&]() { return shards[c] != nullptr; });
+                shard.swap(shards[c]);
+            }
+            index->merge(*shard);
         }
-        prgs[i]->minimizer_sketch(index, w, k);
-        prgs[i]->kmer_prg.save(
-                outdir + "/" + int_to_string(dir_num) + "/" + prgs[i]->name + ".k" + std::to_string(k) + ".w" +
-                std::to_string(w) + ".gfa");
+
+        for (auto &worker : workers)
+            worker.join();
     }
+    for (const auto &prg : prgs)
+        index->num_prgs = std::max(index->num_prgs, prg->id + 1);
+    index->min_path_lengths.resize(index->num_prgs, 0);
+    for (const auto &prg : prgs)
+        index->min_path_lengths[prg->id] = prg->kmer_prg.min_path_length();
+    index->freeze();
+    save_kmergraph_store(prgs, outdir, w, k);
     BOOST_LOG_TRIVIAL(debug) << "Finished adding " << prgs.size() << " LocalPRGs";
-    BOOST_LOG_TRIVIAL(debug) << "Number of keys in Index: " << index->minhash.size();
+    BOOST_LOG_TRIVIAL(debug) << "Number of keys in Index: " << index->num_keys();
 }
-	    
 
+// Adds to an existing index the PRGs which come after the last one it already has, so that a PRG file which has been
+// extended at the end does not need to be indexed again. PRGs keep the id given by their position in the PRG file, so
+// the new ones get ids after the current maximum. Returns the number of PRGs which were sketched.
+uint32_t index_new_prgs(std::vector<std::shared_ptr<LocalPRG>> &prgs,
+                        std::shared_ptr<Index> &index,
+                        const uint32_t w,
+                        const uint32_t k,
+                        const std::string &outdir,
+                        const uint32_t threads) {
+    const auto first_new_id = index->num_prgs;
+    std::vector<std::unique_ptr<KmerGraphStore>> stores;
+    for (const auto &filepath : find_kmergraph_stores(outdir, w, k))
+        stores.emplace_back(new KmerGraphStore(filepath));
+
+    std::vector<std::shared_ptr<LocalPRG>> new_prgs;
+    for (const auto &prg : prgs) {
+        if (prg->id >= first_new_id) {
+            new_prgs.push_back(prg);
+            continue;
+        }
+        // PRGs already indexed must have their kmer graph saved under the same name, or the PRG file has been
+        // reordered. Indexes from older versions of pandora have one GFA file per PRG instead of a store
+        bool found = false;
+        for (const auto &store : stores) {
+            if (!store->contains(prg->id))
+                continue;
+            found = store->name(prg->id) == prg->name;
+            break;
+        }
+        const auto kmer_prg_file = prg->name + ".k" + std::to_string(k) + ".w" + std::to_string(w) + ".gfa";
+        if (!found and !fs::exists(outdir + "/" + int_to_string(prg->id / 4000 + 1) + "/" + kmer_prg_file)
+            and !fs::exists(outdir + "/" + kmer_prg_file)) {
+            BOOST_LOG_TRIVIAL(error) << "PRG " << prg->name << " with id " << prg->id << " is in the index but its "
+                                     << "kmer graph is not in " << outdir << ". New PRGs can only be appended at the "
+                                     << "end of the PRG file";
+            exit(1);
+        }
+    }
+    stores.clear();
+    BOOST_LOG_TRIVIAL(info) << "Index already has " << first_new_id << " PRGs, adding " << new_prgs.size();
+    index_prgs(new_prgs, index, w, k, outdir, threads);
+    return new_prgs.size();
+}
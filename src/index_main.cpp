@@ -9,16 +9,19 @@
 
 #include "utils.h"
 #include "localPRG.h"
+#include "localgraph_store.h"
 
 static void show_index_usage() {
     std::cerr << "Usage: pandora index [options] <prgs.fa>\n"
               << "Options:\n"
               << "\t-h,--help\t\t\tShow this help message\n"
-              //<< "\t-u, --update\t\tLook for an index and add only PRGs with new names\n"
               << "\t-w W\t\t\t\tWindow size for (w,k)-minimizers, default 14\n"
               << "\t-k K\t\t\t\tK-mer size for (w,k)-minimizers, default 15\n"
               << "\t--offset\t\t\t\tOffset for PRG ids, default 0\n"
               << "\t--outfile\t\t\t\tFilename for index\n"
+              << "\t-t,--threads T\t\t\tNumber of threads used to load and sketch the PRGs, default 1\n"
+              << "\t-a,--append\t\t\tAdd the PRGs after the last one in an existing index to it, in place\n"
+              << "\t--text\t\t\t\tSave the index in the legacy text format instead of binary\n"
               << "\t--log_level\t\t\tdebug,[info],warning,error\n"
               << std::endl;
 }
@@ -33,15 +36,15 @@ int pandora_index(int argc, char *argv[]) // the "pandora index" comand
 
     // otherwise, parse the parameters from the command line
     std::string prgfile, index_outfile = "", log_level="info";
-    bool update = false;
-    uint32_t w = 14, k = 15, id=0; // default parameters
+    bool append = false, text_index = false;
+    uint32_t w = 14, k = 15, id=0, threads = 1; // default parameters
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if ((arg == "-h") || (arg == "--help")) {
             show_index_usage();
             return 0;
-        } else if ((arg == "-u") || (arg == "--update")) {
-            update = true;
+        } else if ((arg == "-a") || (arg == "--append")) {
+            append = true;
         } else if (arg == "-w") {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
                 w = (unsigned) atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
@@ -70,6 +73,15 @@ int pandora_index(int argc, char *argv[]) // the "pandora index" comand
                 std::cerr << "--outfile option requires one argument." << std::endl;
                 return 1;
             }
+        } else if ((arg == "-t") || (arg == "--threads")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                threads = (unsigned) atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--threads option requires one argument." << std::endl;
+                return 1;
+            }
+        } else if (arg == "--text") {
+            text_index = true;
         } else if ((arg == "--log_level")) {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
                 log_level = argv[++i]; // Increment 'i' so we don't get the argument as the next argv[i].
@@ -92,7 +104,9 @@ int pandora_index(int argc, char *argv[]) // the "pandora index" comand
 
     // load PRGs from file
     std::vector<std::shared_ptr<LocalPRG>> prgs;
-    read_prg_file(prgs, prgfile, id);
+    read_prg_file(prgs, prgfile, id, threads);
+
+    save_localgraph_store(prgs, localgraph_store_path(prgfile));
 
     // get output directory for the gfa
     boost::filesystem::path p(prgfile);
@@ -102,17 +116,27 @@ int pandora_index(int argc, char *argv[]) // the "pandora index" comand
         outdir = ".";
     outdir += "/kmer_prgs";
 
+    if (index_outfile.empty()) {
+        index_outfile = id > 0 ? prgfile + "." + std::to_string(id) : prgfile;
+        index_outfile += ".k" + std::to_string(k) + ".w" + std::to_string(w) + ".idx";
+    }
+
     // index PRGs
     auto index = std::make_shared<Index>();
-    index_prgs(prgs, index, w, k, outdir);
+    if (append and boost::filesystem::exists(index_outfile)) {
+        index->load(index_outfile);
+        index_new_prgs(prgs, index, w, k, outdir, threads);
+    } else {
+        if (append)
+            BOOST_LOG_TRIVIAL(info) << "No index " << index_outfile << " to append to, indexing all PRGs";
+        index_prgs(prgs, index, w, k, outdir, threads);
+    }
 
     // save index
-    if (index_outfile != "")
-        index->save(index_outfile);
-    else if (id > 0)
-        index->save(prgfile+"."+std::to_string(id), w, k);
+    if (text_index)
+        index->save_text(index_outfile);
     else
-        index->save(prgfile, w, k);
+        index->save(index_outfile);
 
     return 0;
 }
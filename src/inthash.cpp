@@ -4,6 +4,11 @@
 #include <cstring>
 #include "inthash.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PANDORA_HASH64_X86
+#include <immintrin.h>
+#endif
+
 
 /* Taken from Heng Li minimap https://github.com/lh3/minimap/blob/master/sketch.c
  *
@@ -124,6 +129,73 @@ uint64_t hash64(uint64_t key, const uint64_t &mask) {
     return key;
 }
 
+#ifdef PANDORA_HASH64_X86
+// hash64 on 2 keys at a time, SSE2 is part of x86-64 so needs no check
+static size_t hash64_batch_sse2(uint64_t *keys, const size_t n, const uint64_t &mask) {
+    const __m128i m = _mm_set1_epi64x(mask), ones = _mm_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+        key = _mm_and_si128(_mm_add_epi64(_mm_xor_si128(key, ones), _mm_slli_epi64(key, 21)), m);
+        key = _mm_xor_si128(key, _mm_srli_epi64(key, 24));
+        key = _mm_and_si128(_mm_add_epi64(_mm_add_epi64(key, _mm_slli_epi64(key, 3)), _mm_slli_epi64(key, 8)), m);
+        key = _mm_xor_si128(key, _mm_srli_epi64(key, 14));
+        key = _mm_and_si128(_mm_add_epi64(_mm_add_epi64(key, _mm_slli_epi64(key, 2)), _mm_slli_epi64(key, 4)), m);
+        key = _mm_xor_si128(key, _mm_srli_epi64(key, 28));
+        key = _mm_and_si128(_mm_add_epi64(key, _mm_slli_epi64(key, 31)), m);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(keys + i), key);
+    }
+    return i;
+}
+
+// hash64 on 4 keys at a time, only called once the CPU is known to have AVX2
+__attribute__((target("avx2")))
+static size_t hash64_batch_avx2(uint64_t *keys, const size_t n, const uint64_t &mask) {
+    const __m256i m = _mm256_set1_epi64x(mask), ones = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+        key = _mm256_and_si256(_mm256_add_epi64(_mm256_xor_si256(key, ones), _mm256_slli_epi64(key, 21)), m);
+        key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 24));
+        key = _mm256_and_si256(
+                _mm256_add_epi64(_mm256_add_epi64(key, _mm256_slli_epi64(key, 3)), _mm256_slli_epi64(key, 8)), m);
+        key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 14));
+        key = _mm256_and_si256(
+                _mm256_add_epi64(_mm256_add_epi64(key, _mm256_slli_epi64(key, 2)), _mm256_slli_epi64(key, 4)), m);
+        key = _mm256_xor_si256(key, _mm256_srli_epi64(key, 28));
+        key = _mm256_and_si256(_mm256_add_epi64(key, _mm256_slli_epi64(key, 31)), m);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(keys + i), key);
+    }
+    _mm256_zeroupper(); // or the SSE code which runs next stalls on the upper halves of the registers
+    return i;
+}
+#endif
+
+Hash64Isa hash64_batch_best_isa() {
+#ifdef PANDORA_HASH64_X86
+    static const Hash64Isa best = __builtin_cpu_supports("avx2") ? Hash64Isa::avx2 : Hash64Isa::sse2;
+    return best;
+#else
+    return Hash64Isa::scalar;
+#endif
+}
+
+// the hashes do not depend on each other, so are computed several at a time in vector registers when the CPU allows,
+// falling back to plain hash64 for isas it does not have and for the keys left over
+void hash64_batch(uint64_t *keys, const size_t n, const uint64_t &mask, Hash64Isa isa) {
+    if (isa > hash64_batch_best_isa())
+        isa = hash64_batch_best_isa();
+    size_t i = 0;
+#ifdef PANDORA_HASH64_X86
+    if (isa == Hash64Isa::avx2)
+        i = hash64_batch_avx2(keys, n, mask);
+    else if (isa == Hash64Isa::sse2)
+        i = hash64_batch_sse2(keys, n, mask);
+#endif
+    for (; i < n; ++i)
+        keys[i] = hash64(keys[i], mask);
+}
+
 /* Now use these functions in my own code */
 
 std::pair<uint64_t, uint64_t> KmerHash::kmerhash(const std::string &s, const uint32_t k) {
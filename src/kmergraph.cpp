@@ -5,6 +5,7 @@
 #include <cstdio>      /* NULL */
 #include <cstdlib>     /* srand, rand */
 #include <cmath>
+#include <cstring>
 
 #include <boost/math/distributions/negative_binomial.hpp>
 #include <boost/log/trivial.hpp>
@@ -36,7 +37,7 @@ KmerGraph::KmerGraph() {
 // copy constructor
 KmerGraph::KmerGraph(const KmerGraph &other) {
     num_reads = other.num_reads;
-    shortest_path_length = other.shortest_path_length;
+    shortest_path_length = other.shortest_path_length.load();
     k = other.k;
     p = other.p;
     nb_p = other.nb_p;
@@ -50,10 +51,12 @@ KmerGraph::KmerGraph(const KmerGraph &other) {
     nodes.reserve(other.nodes.size());
 
     // create deep copies of the nodes, minus the edges
+    nodes_by_path.reserve(other.nodes.size());
     for (const auto &node : other.nodes) {
         n = std::make_shared<KmerNode>(*node);
         assert(nodes.size() == n->id);
         nodes.push_back(n);
+        nodes_by_path.emplace(n->path_id, n);
     }
 
     // now need to copy the edges
@@ -80,7 +83,7 @@ KmerGraph &KmerGraph::operator=(const KmerGraph &other) {
 
     // shallow copy no pointers
     num_reads = other.num_reads;
-    shortest_path_length = other.shortest_path_length;
+    shortest_path_length = other.shortest_path_length.load();
     k = other.k;
     p = other.p;
     nb_p = other.nb_p;
@@ -90,10 +93,12 @@ KmerGraph &KmerGraph::operator=(const KmerGraph &other) {
     KmerNodePtr n;
 
     // create deep copies of the nodes, minus the edges
+    nodes_by_path.reserve(other.nodes.size());
     for (const auto &node : other.nodes) {
         n = std::make_shared<KmerNode>(*node);
         assert(nodes.size() == n->id);
         nodes.push_back(n);
+        nodes_by_path.emplace(n->path_id, n);
     }
 
     // now need to copy the edges
@@ -116,6 +121,7 @@ KmerGraph::~KmerGraph() {
 void KmerGraph::clear() {
     nodes.clear();
     assert(nodes.empty());
+    nodes_by_path.clear();
 
     sorted_nodes.clear();
     assert(sorted_nodes.empty());
@@ -130,16 +136,27 @@ void KmerGraph::clear() {
     exp_depth_covg = 0;
 }
 
+// Returns the node with this kmer path, or nullptr if there is none. Paths are interned, so equal paths have equal ids
+// and nodes can be looked up by id. The lookup table is only read here, so may be shared by threads.
+KmerNodePtr KmerGraph::find_node(const prg::PathId path_id) const {
+    const auto found = nodes_by_path.find(path_id);
+    if (found == nodes_by_path.end()) {
+        return nullptr;
+    }
+    return found->second;
+}
+
 KmerNodePtr KmerGraph::add_node(const prg::Path &p) { //add this kmer path to this kmer graph
-    for (const auto &c : nodes) { //check if this kmer path is already added
-        if (c->path == p) { //TODO: overload operator == to receive a prg::Path?
-            return c;
-        }
+    const auto path_id = prg::intern(p);
+    const auto found = find_node(path_id); //check if this kmer path is already added
+    if (found != nullptr) {
+        return found;
     }
 
     // if we didn't find an existing node, add this kmer path to the graph
-    KmerNodePtr n(std::make_shared<KmerNode>(nodes.size(), p)); //create the node
+    KmerNodePtr n(std::make_shared<KmerNode>(nodes.size(), path_id)); //create the node
     nodes.push_back(n); //add it to nodes
+    nodes_by_path.emplace(path_id, n);
     //nodes[next_id] = make_shared<KmerNode>(next_id, p);
     assert(k == 0 or p.length() == 0 or p.length() == k);
     if (k == 0 and p.length() > 0) {
@@ -164,15 +181,15 @@ KmerNodePtr KmerGraph::add_node_with_kh(const prg::Path &p, const uint64_t &kh,
 
 condition::condition(const prg::Path &p) : q(p) {};
 
-bool condition::operator()(const KmerNodePtr kn) const { return kn->path == q; }
+bool condition::operator()(const KmerNodePtr kn) const { return kn->path() == q; }
 
 void KmerGraph::add_edge(KmerNodePtr from, KmerNodePtr to) {
     assert(from->id < nodes.size() and nodes[from->id] == from);
     assert(to->id < nodes.size() and nodes[to->id] == to);
-    assert(from->path < to->path
+    assert(from->path() < to->path()
            or assert_msg(
-            "Cannot add edge from " << from->id << " to " << to->id << " because " << from->path << " is not less than "
-                                    << to->path));
+            "Cannot add edge from " << from->id << " to " << to->id << " because " << from->path() << " is not less than "
+                                    << to->path()));
 
     if (find(from->outNodes.begin(), from->outNodes.end(), to) == from->outNodes.end()) {
         from->outNodes.emplace_back(to);
@@ -194,15 +211,15 @@ void KmerGraph::remove_shortcut_edges() {
             for (auto next_out = out->outNodes.begin(); next_out != out->outNodes.end();) {
                 // if the outnode of an outnode of A is another outnode of A
                 if (find(n->outNodes.begin(), n->outNodes.end(), *next_out) != n->outNodes.end()) {
-                    temp_path = get_union(n->path, (*next_out)->path);
+                    temp_path = get_union(n->path(), (*next_out)->path());
 
-                    if (out->path.is_subpath(temp_path)) {
+                    if (out->path().is_subpath(temp_path)) {
                         //remove it from the outnodes
-                        BOOST_LOG_TRIVIAL(debug) << "found the union of " << n->path << " and " << (*next_out)->path;
-                        BOOST_LOG_TRIVIAL(debug) << "result " << temp_path << " contains " << out->path;
+                        BOOST_LOG_TRIVIAL(debug) << "found the union of " << n->path() << " and " << (*next_out)->path();
+                        BOOST_LOG_TRIVIAL(debug) << "result " << temp_path << " contains " << out->path();
                         (*next_out)->inNodes.erase(find((*next_out)->inNodes.begin(), (*next_out)->inNodes.end(), out));
                         next_out = out->outNodes.erase(next_out);
-                        BOOST_LOG_TRIVIAL(debug) << "next out is now " << (*next_out)->path;
+                        BOOST_LOG_TRIVIAL(debug) << "next out is now " << (*next_out)->path();
                         num_removed_edges += 1;
                         break;
                     } else {
@@ -237,7 +254,7 @@ void KmerGraph::check() {
                 "node" << **c << " has outNodes size " << (*c)->outNodes.size() << " and isn't equal to back node "
                        << *sorted_nodes.back()));
         for (const auto &d: (*c)->outNodes) {
-            assert((*c)->path < d->path || assert_msg((*c)->path << " is not less than " << d->path));
+            assert((*c)->path() < d->path() || assert_msg((*c)->path() << " is not less than " << d->path()));
             assert(find(c, sorted_nodes.end(), d) != sorted_nodes.end() ||
                    assert_msg(d->id << " does not occur later in sorted list than " << (*c)->id));
         }
@@ -249,7 +266,7 @@ void KmerGraph::discover_k() {
         auto it = nodes.begin();
         it++;
         const auto &knode = **it;
-        k = knode.path.length();
+        k = knode.path().length();
     }
 }
 
@@ -593,10 +610,10 @@ float KmerGraph::prob_path(const std::vector<KmerNodePtr> &kpath,
         ret_p += prob(kpath[i]->id, sample_id);
     }
     uint32_t len = kpath.size();
-    if (kpath[0]->path.length() == 0) {
+    if (kpath[0]->path().length() == 0) {
         len -= 1;
     }
-    if (kpath.back()->path.length() == 0) {
+    if (kpath.back()->path().length() == 0) {
         len -= 1;
     }
     if (len == 0) {
@@ -626,7 +643,7 @@ float KmerGraph::prob_paths(const std::vector<std::vector<KmerNodePtr>> &kpaths)
         if (path_node_covg[i] > 0) {
             //cout << "prob of node " << nodes[i]->id << " which has path covg " << path_node_covg[i] << " and so we expect to see " << num_reads*path_node_covg[i]/kpaths.size() << " times IS " << prob(nodes[i]->id, num_reads*path_node_covg[i]/kpaths.size()) << endl;
             ret_p += prob(nodes[i]->id, num_reads * path_node_covg[i] / kpaths.size(), <#initializer#>);
-            if (nodes[i]->path.length() > 0) {
+            if (nodes[i]->path().length() > 0) {
                 len += 1;
             }
         }
@@ -661,9 +678,17 @@ void KmerGraph::save_covg_dist(const std::string &filepath) {
     handle.close();
 }
 
+// may be called from several threads at once, which wait for the first to work it out
 uint32_t KmerGraph::min_path_length() {
-    if (shortest_path_length > 0) {
-        return shortest_path_length;
+    uint32_t memoized = shortest_path_length.load(std::memory_order_acquire);
+    if (memoized > 0) {
+        return memoized;
+    }
+
+    std::lock_guard<std::mutex> lock(min_path_length_mutex);
+    memoized = shortest_path_length.load(std::memory_order_acquire);
+    if (memoized > 0) {
+        return memoized;
     }
 
     if (sorted_nodes.empty()) {
@@ -679,7 +704,7 @@ uint32_t KmerGraph::min_path_length() {
             }
         }
     }
-    shortest_path_length = len[0];
+    shortest_path_length.store(len[0], std::memory_order_release);
     return len[0];
 }
 
@@ -694,9 +719,9 @@ void KmerGraph::save(const std::string &filepath, const std::shared_ptr<LocalPRG
             handle << "S\t" << c->id << "\t";
 
             if (localprg != nullptr) {
-                handle << localprg->string_along_path(c->path);
+                handle << localprg->string_along_path(c->path());
             } else {
-                handle << c->path;
+                handle << c->path();
             }
 
             handle << "\tFC:i:" << c->get_covg(0, sample_id) << "\t" << "\tRC:i:"
@@ -713,110 +738,240 @@ void KmerGraph::save(const std::string &filepath, const std::shared_ptr<LocalPRG
     }
 }
 
+namespace {
+    // reads the next tab separated field of [pos, end) into [field, field_end), skipping empty fields as split did
+    bool next_field(const char *&pos, const char *end, const char *&field, const char *&field_end) {
+        while (pos != end and *pos == '\t')
+            ++pos;
+        if (pos == end)
+            return false;
+        field = pos;
+        while (pos != end and *pos != '\t')
+            ++pos;
+        field_end = pos;
+        return true;
+    }
+
+    // reads the next decimal number of [pos, end), skipping whatever precedes it, such as "FC:i:" or "[" and ", "
+    bool parse_uint(const char *&pos, const char *end, uint32_t &value) {
+        while (pos != end and !isdigit(*pos))
+            ++pos;
+        if (pos == end)
+            return false;
+        value = 0;
+        while (pos != end and isdigit(*pos))
+            value = value * 10 + (*pos++ - '0');
+        return true;
+    }
+
+    // parses a path as written by operator<<, e.g. 2{[0, 3)[5, 7)}, reusing the intervals of p
+    bool parse_path(const char *pos, const char *end, prg::Path &p) {
+        uint32_t num_intervals, start, interval_end;
+        if (!parse_uint(pos, end, num_intervals))
+            return false;
+        p.path.clear();
+        for (uint32_t i = 0; i != num_intervals; ++i) {
+            if (!parse_uint(pos, end, start) or !parse_uint(pos, end, interval_end) or interval_end < start)
+                return false;
+            p.path.emplace_back(start, interval_end);
+        }
+        return true;
+    }
+}
+
+// Reads the GFA written by save in a single pass over the file contents, parsing fields in place. Edges are added
+// once all nodes are known, in the order of the L lines, so outNodes and inNodes are as if added while reading.
 void KmerGraph::load(const std::string &filepath) {
     clear();
     uint32_t sample_id = 0;
 
-    std::string line;
-    std::vector<std::string> split_line;
-    std::stringstream ss;
-    uint32_t id = 0, covg, from, to;
-    prg::Path p;
-    uint32_t num_nodes = 0;
+    std::ifstream myfile(filepath, std::ios::binary);
+    if (!myfile.is_open()) {
+        std::cerr << "Unable to open kmergraph file " << filepath << std::endl;
+        exit(1);
+    }
+    std::string buffer;
+    myfile.seekg(0, myfile.end);
+    buffer.resize(myfile.tellg());
+    myfile.seekg(0, myfile.beg);
+    myfile.read(&buffer[0], buffer.size());
+    myfile.close();
 
-    std::ifstream myfile(filepath);
-    if (myfile.is_open()) {
+    // a file which cannot be read is reported, as a file which cannot be opened is
+    const auto fail = [&filepath](const std::string &reason) {
+        std::cerr << "Unable to read kmergraph file " << filepath << ": " << reason << std::endl;
+        exit(1);
+    };
 
-        while (getline(myfile, line).good()) {
-            if (line[0] == 'S') {
-                split_line = split(line, "\t");
-                assert(split_line.size() >= 4);
-                id = std::stoi(split_line[1]);
-                num_nodes = std::max(num_nodes, id);
+    uint32_t id = 0, covg, from, to;
+    uint32_t num_nodes = 0;
+    prg::Path p;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    const char *field, *field_end;
+    const char *line = buffer.data(), *const end = buffer.data() + buffer.size();
+    while (line != end) {
+        auto line_end = static_cast<const char *>(memchr(line, '\n', end - line));
+        if (line_end == nullptr)
+            line_end = end;
+        const char *pos = line;
+        if (*line == 'S') {
+            bool ok = next_field(pos, line_end, field, field_end) // S
+                      and next_field(pos, line_end, field, field_end) and parse_uint(field, field_end, id);
+            if (!ok)
+                fail("cannot read the id of GFA line " + std::string(line, line_end));
+            num_nodes = std::max(num_nodes, id);
+            ok = next_field(pos, line_end, field, field_end);
+            if (!(ok and isdigit(*field)))
+                fail("cannot read in this sort of kmergraph GFA as it does not label nodes with their PRG path");
+            ok = parse_path(field, field_end, p);
+            if (!ok)
+                fail("cannot read the path of GFA line " + std::string(line, line_end));
+            KmerNodePtr n = std::make_shared<KmerNode>(id, p);
+            nodes.push_back(n);
+            nodes_by_path.emplace(n->path_id, n);
+            if (k == 0 and p.length() > 0) {
+                k = p.length();
             }
-        }
-        myfile.clear();
-        myfile.seekg(0, myfile.beg);
-        nodes.reserve(num_nodes);
-        std::vector<uint16_t> outnode_counts(num_nodes + 1, 0), innode_counts(num_nodes + 1, 0);
-
-        while (getline(myfile, line).good()) {
-            if (line[0] == 'S') {
-                split_line = split(line, "\t");
-                assert(split_line.size() >= 4);
-                id = stoi(split_line[1]);
-                ss << split_line[2];
-                char c = ss.peek();
-                assert (isdigit(c) or assert_msg("Cannot read in this sort of kmergraph GFA as it does not label nodes "
-                                                 "with their PRG path"));
-                ss >> p;
-                ss.clear();
-                //add_node(p);
-                KmerNodePtr n = std::make_shared<KmerNode>(id, p);
-                assert(n != nullptr);
-                assert(id == nodes.size() or num_nodes - id == nodes.size() or
-                       assert_msg("id " << id << " != " << nodes.size() << " nodes.size() for kmergraph "));
-                nodes.push_back(n);
-                if (k == 0 and p.length() > 0) {
-                    k = p.length();
-                }
-                covg = stoi(split(split_line[3], "FC:i:")[0]);
-                n->set_covg(covg, 0, sample_id);
-                covg = stoi(split(split_line[4], "RC:i:")[0]);
-                n->set_covg(covg, 1, sample_id);
-                if (split_line.size() >= 6) {
-                    n->num_AT = std::stoi(split_line[5]);
-                }
-            } else if (line[0] == 'L') {
-                split_line = split(line, "\t");
-                assert(split_line.size() >= 5);
-                assert(stoi(split_line[1]) < (int) outnode_counts.size() or
-                       assert_msg(stoi(split_line[1]) << ">=" << outnode_counts.size()));
-                assert(stoi(split_line[3]) < (int) innode_counts.size() or
-                       assert_msg(stoi(split_line[3]) << ">=" << innode_counts.size()));
-                outnode_counts[stoi(split_line[1])] += 1;
-                innode_counts[stoi(split_line[3])] += 1;
+            ok = next_field(pos, line_end, field, field_end) and parse_uint(field, field_end, covg);
+            if (!ok)
+                fail("cannot read FC of GFA line " + std::string(line, line_end));
+            n->set_covg(covg, 0, sample_id);
+            ok = next_field(pos, line_end, field, field_end) and parse_uint(field, field_end, covg);
+            if (!ok)
+                fail("cannot read RC of GFA line " + std::string(line, line_end));
+            n->set_covg(covg, 1, sample_id);
+            if (next_field(pos, line_end, field, field_end) and parse_uint(field, field_end, covg)) {
+                n->num_AT = covg;
+            }
+        } else if (*line == 'L') {
+            const char *from_strand, *from_strand_end, *to_strand, *to_strand_end;
+            const bool ok = next_field(pos, line_end, field, field_end) // L
+                            and next_field(pos, line_end, field, field_end) and parse_uint(field, field_end, from)
+                            and next_field(pos, line_end, from_strand, from_strand_end)
+                            and next_field(pos, line_end, field, field_end) and parse_uint(field, field_end, to)
+                            and next_field(pos, line_end, to_strand, to_strand_end);
+            if (!ok)
+                fail("cannot read GFA line " + std::string(line, line_end));
+            if (from_strand_end - from_strand == to_strand_end - to_strand
+                and std::equal(from_strand, from_strand_end, to_strand)) {
+                edges.emplace_back(from, to);
+            } else {
+                // never happens
+                edges.emplace_back(to, from);
             }
         }
+        line = line_end == end ? end : line_end + 1;
+    }
 
-        if (id == 0) {
-            reverse(nodes.begin(), nodes.end());
-        }
+    for (uint32_t i = 0; i != nodes.size(); ++i) {
+        if (nodes[i]->id != i and num_nodes - nodes[i]->id != i)
+            fail("node " + std::to_string(nodes[i]->id) + " is out of order, at position " + std::to_string(i)
+                 + " of the nodes");
+    }
+    if (id == 0) {
+        reverse(nodes.begin(), nodes.end());
+    }
+
+    std::vector<uint32_t> outnode_counts(nodes.size(), 0), innode_counts(nodes.size(), 0);
+    for (const auto &edge : edges) {
+        if (edge.first >= nodes.size() or edge.second >= nodes.size())
+            fail("edge " + std::to_string(edge.first) + " to " + std::to_string(edge.second) + " is to a node which "
+                 "is not in the graph, of " + std::to_string(nodes.size()) + " nodes");
+        outnode_counts[edge.first] += 1;
+        innode_counts[edge.second] += 1;
+    }
+    for (const auto &n : nodes) {
+        assert(nodes[n->id] == n);
+        n->outNodes.reserve(outnode_counts[n->id]);
+        n->inNodes.reserve(innode_counts[n->id]);
+    }
+    for (const auto &edge : edges) {
+        add_edge(nodes[edge.first], nodes[edge.second]);
+    }
+}
 
-        id = 0;
-        for (const auto &n : nodes) {
-            assert(nodes[id]->id == id);
-            id++;
-            assert(n->id < outnode_counts.size() or assert_msg(n->id << ">=" << outnode_counts.size()));
-            assert(n->id < innode_counts.size() or assert_msg(n->id << ">=" << innode_counts.size()));
-            n->outNodes.reserve(outnode_counts[n->id]);
-            n->inNodes.reserve(innode_counts[n->id]);
+// Nodes are written in id order, each as its path (intervals as gap from the end of the previous interval and length)
+// and coverages, followed by the out edges of every node. Reading the edges back in the same order gives the same
+// outNodes and inNodes as loading the GFA written by save.
+void KmerGraph::encode(std::string &buffer) const {
+    const uint32_t sample_id = 0;
+    encode_varint(buffer, nodes.size());
+    for (const auto &n : nodes) {
+        assert(n->id == (uint32_t) (&n - &nodes[0]));
+        const auto &intervals = n->path().path;
+        encode_varint(buffer, intervals.size());
+        uint32_t previous_end = 0;
+        for (const auto &interval : intervals) {
+            assert(interval.start >= previous_end);
+            encode_varint(buffer, interval.start - previous_end);
+            encode_varint(buffer, interval.length);
+            previous_end = interval.get_end();
         }
+        encode_varint(buffer, n->get_covg(0, sample_id));
+        encode_varint(buffer, n->get_covg(1, sample_id));
+    }
+    for (const auto &n : nodes) {
+        encode_varint(buffer, n->outNodes.size());
+        for (const auto &out : n->outNodes)
+            encode_varint(buffer, out->id);
+    }
+}
 
-        myfile.clear();
-        myfile.seekg(0, myfile.beg);
+bool KmerGraph::decode(const char *&data, const char *end) {
+    clear();
+    const uint32_t sample_id = 0;
+    uint32_t num_nodes, num_intervals, gap, length, covg;
+    if (!decode_varint(data, end, num_nodes))
+        return false;
+    nodes.reserve(num_nodes);
+    prg::Path p;
+    for (uint32_t id = 0; id != num_nodes; ++id) {
+        if (!decode_varint(data, end, num_intervals))
+            return false;
+        p.path.clear();
+        uint32_t previous_end = 0;
+        for (uint32_t i = 0; i != num_intervals; ++i) {
+            if (!decode_varint(data, end, gap) or !decode_varint(data, end, length))
+                return false;
+            p.path.emplace_back(previous_end + gap, previous_end + gap + length);
+            previous_end += gap + length;
+        }
+        KmerNodePtr n = std::make_shared<KmerNode>(id, p);
+        nodes.push_back(n);
+        nodes_by_path.emplace(n->path_id, n);
+        if (k == 0 and p.length() > 0) {
+            k = p.length();
+        }
+        if (!decode_varint(data, end, covg))
+            return false;
+        n->set_covg(covg, 0, sample_id);
+        if (!decode_varint(data, end, covg))
+            return false;
+        n->set_covg(covg, 1, sample_id);
+    }
 
-        while (getline(myfile, line).good()) {
-            if (line[0] == 'L') {
-                split_line = split(line, "\t");
-                assert(split_line.size() >= 5);
-                if (split_line[2] == split_line[4]) {
-                    from = std::stoi(split_line[1]);
-                    to = std::stoi(split_line[3]);
-                } else {
-                    // never happens
-                    from = std::stoi(split_line[3]);
-                    to = std::stoi(split_line[1]);
-                }
-                add_edge(nodes[from], nodes[to]);
-                //nodes[from]->outNodes.push_back(nodes.at(to));
-                //nodes[to]->inNodes.push_back(nodes.at(from));
-            }
+    std::vector<std::vector<uint32_t>> out_ids(num_nodes);
+    std::vector<uint32_t> innode_counts(num_nodes, 0);
+    for (auto &ids : out_ids) {
+        uint32_t num_out, to;
+        if (!decode_varint(data, end, num_out))
+            return false;
+        ids.reserve(num_out);
+        for (uint32_t j = 0; j != num_out; ++j) {
+            if (!decode_varint(data, end, to) or to >= num_nodes)
+                return false;
+            ids.push_back(to);
+            innode_counts[to] += 1;
         }
-    } else {
-        std::cerr << "Unable to open kmergraph file " << filepath << std::endl;
-        exit(1);
     }
+    for (uint32_t id = 0; id != num_nodes; ++id) {
+        nodes[id]->outNodes.reserve(out_ids[id].size());
+        nodes[id]->inNodes.reserve(innode_counts[id]);
+    }
+    for (uint32_t from = 0; from != num_nodes; ++from)
+        for (const auto to : out_ids[from])
+            add_edge(nodes[from], nodes[to]);
+    return true;
 }
 
 bool KmerGraph::operator==(const KmerGraph &y) const {
@@ -829,18 +984,18 @@ bool KmerGraph::operator==(const KmerGraph &y) const {
     for (const auto &kmer_node_ptr: nodes) {
         const auto &kmer_node = *kmer_node_ptr;
         // if node not equal to a node in y, then false
-        auto found = find_if(y.nodes.begin(), y.nodes.end(), condition(kmer_node.path));
-        if (found == y.nodes.end()) {
+        const auto found = y.find_node(kmer_node.path_id);
+        if (found == nullptr) {
             return false;
         }
 
         // if the node is found but has different edges, then false
-        if (kmer_node.outNodes.size() != (*found)->outNodes.size()) { return false; }
-        if (kmer_node.inNodes.size() != (*found)->inNodes.size()) { return false; }
+        if (kmer_node.outNodes.size() != found->outNodes.size()) { return false; }
+        if (kmer_node.inNodes.size() != found->inNodes.size()) { return false; }
         for (uint32_t j = 0; j != kmer_node.outNodes.size(); ++j) {
             spointer_values_equal<KmerNode> eq = {kmer_node.outNodes[j]};
-            if (find_if((*found)->outNodes.begin(), (*found)->outNodes.end(), eq) ==
-                (*found)->outNodes.end()) { return false; }
+            if (find_if(found->outNodes.begin(), found->outNodes.end(), eq) ==
+                found->outNodes.end()) { return false; }
         }
 
     }
@@ -855,7 +1010,7 @@ void KmerGraph::setup_coverages(const uint32_t &total_number_samples) {
 }
 
 bool pCompKmerNode::operator()(KmerNodePtr lhs, KmerNodePtr rhs) {
-    return (lhs->path) < (rhs->path);
+    return (lhs->path()) < (rhs->path());
 }
 
 std::ostream &operator<<(std::ostream &out, KmerGraph const &data) {
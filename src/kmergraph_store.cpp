@@ -0,0 +1,271 @@
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+
+#include "kmergraph_store.h"
+#include "localPRG.h"
+#include "utils.h"
+
+// Kmer graph store layout, integers in host byte order:
+//   KmerGraphStoreHeader
+//   graphs back to back, each the uint32_t length and characters of the PRG name followed by KmerGraph::encode
+//   padding to an 8 byte boundary
+//   uint64_t offsets[num_graphs + 1]   the graph of PRG first_id + i is at [offsets[i], offsets[i+1]), empty if absent
+//   KmerGraphStoreFooter
+// The table is at the end so that graphs of new PRGs can be appended by rewriting only the table and footer.
+namespace {
+    const char store_magic[8] = {'P', 'A', 'N', 'D', 'K', 'G', 'S', '\0'};
+    const uint32_t store_version = 1;
+
+    struct KmerGraphStoreHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct KmerGraphStoreFooter {
+        uint64_t table_offset;
+        uint32_t first_id;
+        uint32_t num_graphs;
+        uint32_t version;
+        uint32_t reserved;
+        char magic[8];
+    };
+
+    static_assert(sizeof(KmerGraphStoreHeader) == 16, "unexpected padding in KmerGraphStoreHeader");
+    static_assert(sizeof(KmerGraphStoreFooter) == 32, "unexpected padding in KmerGraphStoreFooter");
+
+    std::string store_suffix(const uint32_t w, const uint32_t k) {
+        return ".k" + std::to_string(k) + ".w" + std::to_string(w) + ".bin";
+    }
+
+    std::string store_path(const std::string &dir, const uint32_t first_id, const uint32_t w, const uint32_t k) {
+        return dir + "/kmergraphs." + std::to_string(first_id) + store_suffix(w, k);
+    }
+
+    template<typename T>
+    void write_binary(std::ofstream &handle, const T &value) {
+        handle.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+}
+
+KmerGraphStore::KmerGraphStore(const std::string &filepath) : filepath(filepath), file(filepath) {
+    KmerGraphStoreHeader header;
+    KmerGraphStoreFooter footer;
+    if (file.size() < sizeof(header) + sizeof(uint64_t) + sizeof(footer)) {
+        BOOST_LOG_TRIVIAL(error) << "Kmer graph store " << filepath << " is truncated";
+        exit(1);
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    std::memcpy(&footer, file.data() + file.size() - sizeof(footer), sizeof(footer));
+    if (std::memcmp(header.magic, store_magic, sizeof(store_magic)) != 0
+        or std::memcmp(footer.magic, store_magic, sizeof(store_magic)) != 0) {
+        BOOST_LOG_TRIVIAL(error) << filepath << " is not a kmer graph store, or is truncated";
+        exit(1);
+    }
+    if (header.version != store_version or footer.version != store_version) {
+        BOOST_LOG_TRIVIAL(error) << "Kmer graph store " << filepath << " has format version " << header.version
+                                 << " but this pandora reads version " << store_version << ". Please rerun pandora index";
+        exit(1);
+    }
+    first = footer.first_id;
+    num_graphs = footer.num_graphs;
+    table_offset = footer.table_offset;
+    if (table_offset % sizeof(uint64_t) != 0
+        or table_offset + (num_graphs + 1) * sizeof(uint64_t) + sizeof(footer) != file.size()
+        or offset(num_graphs) > table_offset) {
+        BOOST_LOG_TRIVIAL(error) << "Kmer graph store " << filepath << " has an inconsistent offset table";
+        exit(1);
+    }
+}
+
+uint64_t KmerGraphStore::offset(const uint32_t i) const {
+    return reinterpret_cast<const uint64_t *>(file.data() + table_offset)[i];
+}
+
+bool KmerGraphStore::contains(const uint32_t prg_id) const {
+    return prg_id >= first and prg_id < end_id() and offset(prg_id - first) != offset(prg_id - first + 1);
+}
+
+std::string KmerGraphStore::name(const uint32_t prg_id) const {
+    assert(contains(prg_id));
+    uint32_t length;
+    const char *data = file.data() + offset(prg_id - first);
+    std::memcpy(&length, data, sizeof(length));
+    return std::string(data + sizeof(length), length);
+}
+
+void KmerGraphStore::load(const uint32_t prg_id, KmerGraph &kmer_graph) const {
+    assert(contains(prg_id));
+    uint32_t length;
+    const char *data = file.data() + offset(prg_id - first);
+    const char *end = file.data() + offset(prg_id - first + 1);
+    std::memcpy(&length, data, sizeof(length));
+    data += sizeof(length) + length;
+    if (data > end or !kmer_graph.decode(data, end) or data != end) {
+        BOOST_LOG_TRIVIAL(error) << "Kmer graph of PRG " << prg_id << " in " << filepath << " is corrupt";
+        exit(1);
+    }
+}
+
+KmerGraphLoader::KmerGraphLoader(const std::string &dir, const uint32_t w, const uint32_t k, const uint32_t num_prgs)
+        : dir(dir), w(w), k(k), num_prgs(num_prgs), loaded(new std::once_flag[num_prgs]) {
+    for (const auto &filepath : find_kmergraph_stores(dir, w, k))
+        stores.emplace_back(new KmerGraphStore(filepath));
+}
+
+void KmerGraphLoader::load(LocalPRG &prg) {
+    assert(prg.id < num_prgs);
+    std::call_once(loaded[prg.id], &KmerGraphLoader::load_now, this, std::ref(prg));
+}
+
+void KmerGraphLoader::load_now(LocalPRG &prg) const {
+    BOOST_LOG_TRIVIAL(debug) << "Load kmer graph of PRG " << prg.name;
+    bool found = false;
+    for (const auto &store : stores) {
+        if (!store->contains(prg.id))
+            continue;
+        if (store->name(prg.id) != prg.name) {
+            BOOST_LOG_TRIVIAL(error) << "PRG " << prg.id << " is " << prg.name << " but is " << store->name(prg.id)
+                                     << " in the kmer graph store. Was the index built from a different PRG file?";
+            exit(1);
+        }
+        store->load(prg.id, prg.kmer_prg);
+        found = true;
+        break;
+    }
+    if (!found) {
+        const auto filename = prg.name + ".k" + std::to_string(k) + ".w" + std::to_string(w) + ".gfa";
+        auto filepath = dir + "/" + int_to_string(prg.id / 4000 + 1) + "/" + filename;
+        if (not boost::filesystem::exists(filepath))
+            filepath = dir + "/" + filename;
+        prg.kmer_prg.load(filepath);
+    }
+    // the graphs of PRGs with hits are always sorted, as min_path_length did when it was computed from the graph
+    prg.kmer_prg.sort_topologically();
+}
+
+// paths of the stores for this w and k in dir, in increasing order of their first PRG id
+std::vector<std::string> find_kmergraph_stores(const std::string &dir, const uint32_t w, const uint32_t k) {
+    std::vector<std::pair<uint32_t, std::string>> stores;
+    const std::string prefix = "kmergraphs.", suffix = store_suffix(w, k);
+    if (boost::filesystem::is_directory(dir)) {
+        for (const auto &entry : boost::filesystem::directory_iterator(dir)) {
+            const auto filename = entry.path().filename().string();
+            if (filename.size() <= prefix.size() + suffix.size() or filename.compare(0, prefix.size(), prefix) != 0
+                or filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) != 0)
+                continue;
+            const auto id = filename.substr(prefix.size(), filename.size() - prefix.size() - suffix.size());
+            if (id.find_first_not_of("0123456789") != std::string::npos)
+                continue;
+            stores.emplace_back(std::stoul(id), entry.path().string());
+        }
+    }
+    std::sort(stores.begin(), stores.end());
+
+    std::vector<std::string> filepaths;
+    for (const auto &store : stores)
+        filepaths.push_back(store.second);
+    return filepaths;
+}
+
+// Saves the kmer graphs of prgs, which are in increasing order of id, to a store in dir. If a store in dir ends just
+// before the first of prgs they are appended to it, otherwise a new store is written and replaces any store for the
+// same PRG ids.
+void save_kmergraph_store(const std::vector<std::shared_ptr<LocalPRG>> &prgs, const std::string &dir,
+                          const uint32_t w, const uint32_t k) {
+    if (prgs.empty())
+        return;
+    boost::filesystem::create_directories(dir);
+
+    std::string filepath;
+    uint32_t first_id = prgs.front()->id;
+    std::vector<uint64_t> offsets;
+    for (const auto &existing : find_kmergraph_stores(dir, w, k)) {
+        const KmerGraphStore store(existing);
+        if (store.end_id() == prgs.front()->id) {
+            filepath = existing;
+            first_id = store.first_id();
+            for (uint32_t i = 0; i <= store.end_id() - store.first_id(); ++i)
+                offsets.push_back(store.offset(i));
+        } else if (store.first_id() <= prgs.back()->id and prgs.front()->id < store.end_id()) {
+            BOOST_LOG_TRIVIAL(debug) << "Replacing kmer graph store " << existing;
+            boost::filesystem::remove(existing);
+        }
+    }
+
+    std::ofstream handle;
+    if (filepath.empty()) {
+        filepath = store_path(dir, first_id, w, k);
+        handle.open(filepath, std::ios::binary | std::ios::trunc);
+        KmerGraphStoreHeader header;
+        std::memcpy(header.magic, store_magic, sizeof(store_magic));
+        header.version = store_version;
+        header.reserved = 0;
+        write_binary(handle, header);
+        offsets.push_back(sizeof(header));
+    } else {
+        BOOST_LOG_TRIVIAL(debug) << "Appending kmer graphs to " << filepath;
+        boost::filesystem::resize_file(filepath, offsets.back());
+        handle.open(filepath, std::ios::binary | std::ios::app);
+    }
+    if (!handle.is_open()) {
+        BOOST_LOG_TRIVIAL(error) << "Unable to open kmer graph store " << filepath << " for writing";
+        exit(1);
+    }
+
+    std::string buffer;
+    for (const auto &prg : prgs) {
+        assert(prg->id >= first_id + offsets.size() - 1);
+        while (first_id + offsets.size() - 1 < prg->id) //PRGs without a graph
+            offsets.push_back(offsets.back());
+        buffer.clear();
+        const uint32_t length = prg->name.size();
+        buffer.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        buffer.append(prg->name);
+        prg->kmer_prg.encode(buffer);
+        handle.write(buffer.data(), buffer.size());
+        offsets.push_back(offsets.back() + buffer.size());
+    }
+
+    KmerGraphStoreFooter footer;
+    footer.table_offset = (offsets.back() + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+    footer.first_id = first_id;
+    footer.num_graphs = offsets.size() - 1;
+    footer.version = store_version;
+    footer.reserved = 0;
+    std::memcpy(footer.magic, store_magic, sizeof(store_magic));
+    const char padding[sizeof(uint64_t)] = {0};
+    handle.write(padding, footer.table_offset - offsets.back());
+    handle.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    write_binary(handle, footer);
+    handle.close();
+}
+
+// Loads the kmer graph of each PRG found in a store in dir, and sets its entry of loaded. Returns how many were loaded.
+uint32_t load_kmergraph_stores(std::vector<std::shared_ptr<LocalPRG>> &prgs, std::vector<bool> &loaded,
+                               const std::string &dir, const uint32_t w, const uint32_t k) {
+    uint32_t num_loaded = 0;
+    for (const auto &filepath : find_kmergraph_stores(dir, w, k)) {
+        const KmerGraphStore store(filepath);
+        for (uint32_t i = 0; i != prgs.size(); ++i) {
+            const auto &prg = prgs[i];
+            if (loaded[i] or !store.contains(prg->id))
+                continue;
+            if (store.name(prg->id) != prg->name) {
+                BOOST_LOG_TRIVIAL(error) << "PRG " << prg->id << " is " << prg->name << " but is "
+                                         << store.name(prg->id) << " in " << filepath
+                                         << ". Was the index built from a different PRG file?";
+                exit(1);
+            }
+            store.load(prg->id, prg->kmer_prg);
+            loaded[i] = true;
+            ++num_loaded;
+        }
+    }
+    return num_loaded;
+}
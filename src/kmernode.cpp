@@ -7,15 +7,20 @@
 #include "utils.h"
 
 
-KmerNode::KmerNode(uint32_t i, const prg::Path &p) : id(i), path(p),
+KmerNode::KmerNode(uint32_t i, const prg::Path &p) : id(i), path_id(prg::intern(p)),
                                                 khash(std::numeric_limits<uint64_t>::max()), num_AT(0) {
     this->covg_new = {{0, 0}};
 }
 
+KmerNode::KmerNode(uint32_t i, const prg::PathId p) : id(i), path_id(p), khash(std::numeric_limits<uint64_t>::max()),
+                                                     num_AT(0) {
+    this->covg_new = {{0, 0}};
+}
+
 // copy constructor
 KmerNode::KmerNode(const KmerNode &other) {
     id = other.id;
-    path = other.path;
+    path_id = other.path_id;
     khash = other.khash;
     num_AT = other.num_AT;
     // NB we don't do edges
@@ -30,7 +35,7 @@ KmerNode &KmerNode::operator=(const KmerNode &other) {
         return *this;
 
     id = other.id;
-    path = other.path;
+    path_id = other.path_id;
     khash = other.khash;
     num_AT = other.num_AT;
     // NB we don't do edges
@@ -67,7 +72,7 @@ void KmerNode::set_covg(const uint32_t &value, const bool &strand, const uint32_
 }
 
 std::ostream &operator<<(std::ostream &out, const KmerNode &kmer_node) {
-    out << kmer_node.id << " " << kmer_node.path << " ";
+    out << kmer_node.id << " " << kmer_node.path() << " ";
     for (const auto &sample_coverage: kmer_node.covg_new) {
         out << "(" << sample_coverage.first << ", " << sample_coverage.second << ") ";
     }
@@ -75,5 +80,5 @@ std::ostream &operator<<(std::ostream &out, const KmerNode &kmer_node) {
 }
 
 bool KmerNode::operator==(const KmerNode &y) const {
-    return path == y.path;
+    return path_id == y.path_id;
 }
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <algorithm>
 #include <numeric>
+#include <unordered_set>
 #include <cstdlib>
 
 #include <boost/log/trivial.hpp>
@@ -13,13 +14,17 @@
 #include "inthash.h"
 #include "utils.h"
 #include "fastaq.h"
+#include "kmergraph_store.h"
 
 
 #define assert_msg(x) !(std::cerr << "Assertion failed: " << x << std::endl)
 
 
-LocalPRG::LocalPRG(uint32_t i, const std::string &n, const std::string &p)
-        : next_id(0), buff(" "), next_site(5), id(i), name(n), seq(p), num_hits(2, 0) {
+LocalPRG::LocalPRG(uint32_t i, const std::string &n, const std::string &p, const bool build)
+        : next_id(0), buff(" "), shift_memoization(sketch_memoization_size), walk_memoization(sketch_memoization_size),
+          next_site(5), id(i), name(n), seq(p), num_hits(2, 0) {
+    if (!build)
+        return;
     std::vector<uint32_t> v; //TODO: v is not used - safe to delete - but is passed as a parameter...
     // avoid error if a prg contains only empty space as it's sequence
     if (seq.find_first_not_of("\t\n\v\f\r") != std::string::npos) {
@@ -267,6 +272,17 @@ LocalPRG::build_graph(const Interval &i, const std::vector<uint32_t> &from_ids,
 
 std::vector<prg::Path> LocalPRG::shift(prg::Path p) const {
     // returns all paths of the same length which have been shifted by one position along prg graph
+    // the windows explored from consecutive minimizers overlap, so the same kmer is shifted many times while sketching
+    const auto memoized = shift_memoization.find(p);
+    if (memoized != nullptr)
+        return *memoized;
+    auto shifted = shift_core(p);
+    shift_memoization.insert(p, shifted);
+    return shifted;
+}
+
+
+std::vector<prg::Path> LocalPRG::shift_core(prg::Path p) const {
     prg::Path q;
     q = p.subpath(1, p.length() - 1);
     std::vector<LocalNodePtr> n;
@@ -336,12 +352,15 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
     // clean up after any previous runs
     // although note we can't clear the index because it is also added to by other LocalPRGs
     kmer_prg.clear();
+    shift_memoization.clear();
+    walk_memoization.clear();
 
     // declare variables
     std::vector<prg::Path> walk_paths, shift_paths, v;
     walk_paths.reserve(100);
     shift_paths.reserve(100);
     std::deque<KmerNodePtr> current_leaves, end_leaves;
+    std::unordered_set<uint32_t> queued_leaves; //ids of the nodes in current_leaves
     std::deque<std::vector<prg::Path>> shifts;
     std::deque<Interval> d;
     prg::Path kmer_path;
@@ -366,7 +385,7 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
     }
 
     // find first w,k minimizers
-    walk_paths = prg.walk(prg.nodes.begin()->second->id, 0, w + k - 1); //get all walks to be checked
+    walk_paths = prg.walk(prg.nodes.begin()->second->id, 0, w + k - 1, &walk_memoization); //get all walks to be checked
     if (walk_paths.empty()){
         return; // also trivially not true
     }
@@ -390,7 +409,7 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
                 kh = hash.kmerhash(kmer, k);
                 n = nodes_along_path(kmer_path);
 
-                if (prg.walk(n.back()->id, n.back()->pos.get_end(), w + k - 1).empty()) { //if the walk from the last node and last base of the path along this kmer is empty
+                if (prg.walk(n.back()->id, n.back()->pos.get_end(), w + k - 1, &walk_memoization).empty()) { //if the walk from the last node and last base of the path along this kmer is empty
                     while (kmer_path.get_end() >= n.back()->pos.get_end() and n.back()->outNodes.size() == 1 and
                            n.back()->outNodes[0]->pos.length == 0) {
                         kmer_path.add_end_interval(n.back()->outNodes[0]->pos);
@@ -399,8 +418,8 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
                 }
 
                 if (kh.first == smallest or kh.second == smallest) { //if this kmer is the minimizer
-                    const auto found = find_if(kmer_prg.nodes.begin(), kmer_prg.nodes.end(), condition(kmer_path)); //checks if the kmer path is already in this kmer graph //TODO: improve this, takes 24% of the CPU cycles
-                    if (found == kmer_prg.nodes.end()) {
+                    const auto found = kmer_prg.find_node(prg::intern(kmer_path)); //checks if the kmer path is already in this kmer graph
+                    if (found == nullptr) {
                         // add to index, kmer_prg
                         num_AT = std::count(kmer.begin(), kmer.end(), 'A') + std::count(kmer.begin(), kmer.end(), 'T');
                         kn = kmer_prg.add_node_with_kh(kmer_path, std::min(kh.first, kh.second), num_AT);
@@ -410,6 +429,7 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
                         kmer_prg.add_edge(old_kn, kn);//add an edge from the old minimizer kmer to the current
                         old_kn = kn;
                         current_leaves.push_back(kn); //add to the leaves
+                        queued_leaves.insert(kn->id);
                     }
                 }
             }
@@ -421,12 +441,13 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
     while (!current_leaves.empty()) {
         kn = current_leaves.front();
         current_leaves.pop_front();
+        queued_leaves.erase(kn->id);
         assert(kn->khash < std::numeric_limits<uint64_t>::max());
 
         // find all paths which are this kmernode shifted by one place along the graph
-        shift_paths = shift(kn->path);
+        shift_paths = shift(kn->path());
         if (shift_paths.empty()) {
-            //assert(kn->path.get_start() == 0); not true for a too short test, would be true if all paths long enough to have at least 2 minikmers on...
+            //assert(kn->path().get_start() == 0); not true for a too short test, would be true if all paths long enough to have at least 2 minikmers on...
             end_leaves.push_back(kn);
         }
         for (uint32_t i = 0; i != shift_paths.size(); ++i) {
@@ -443,24 +464,24 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
             kh = hash.kmerhash(kmer, k);
             if (std::min(kh.first, kh.second) <= kn->khash) {
                 // found next minimizer
-                const auto found = find_if(kmer_prg.nodes.begin(), kmer_prg.nodes.end(), condition(v.back()));
-                if (found == kmer_prg.nodes.end()) {
+                const auto found = kmer_prg.find_node(prg::intern(v.back()));
+                if (found == nullptr) {
                     num_AT = std::count(kmer.begin(), kmer.end(), 'A') + std::count(kmer.begin(), kmer.end(), 'T');
                     new_kn = kmer_prg.add_node_with_kh(v.back(), std::min(kh.first, kh.second), num_AT);
                     index->add_record(std::min(kh.first, kh.second), id, v.back(), new_kn->id, (kh.first <= kh.second));
                     kmer_prg.add_edge(kn, new_kn);
                     if (v.back().get_end() == (--(prg.nodes.end()))->second->pos.get_end()) {
                         end_leaves.push_back(new_kn);
-                    } else if (find(current_leaves.begin(), current_leaves.end(), new_kn) == current_leaves.end()) {
+                    } else if (queued_leaves.insert(new_kn->id).second) {
                         current_leaves.push_back(new_kn);
                     }
                     num_kmers_added += 1;
                 } else {
-                    kmer_prg.add_edge(kn, *found);
+                    kmer_prg.add_edge(kn, found);
                     if (v.back().get_end() == (--(prg.nodes.end()))->second->pos.get_end()) {
-                        end_leaves.push_back(*found);
-                    } else if (find(current_leaves.begin(), current_leaves.end(), *found) == current_leaves.end()) {
-                        current_leaves.push_back(*found);
+                        end_leaves.push_back(found);
+                    } else if (queued_leaves.insert(found->id).second) {
+                        current_leaves.push_back(found);
                     }
                 }
             } else if (v.size() == w) {
@@ -477,8 +498,8 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
                     kmer = string_along_path(v[j]);
                     kh = hash.kmerhash(kmer, k);
                     if (kh.first == smallest or kh.second == smallest) {
-                        const auto found = find_if(kmer_prg.nodes.begin(), kmer_prg.nodes.end(), condition(v[j]));
-                        if (found == kmer_prg.nodes.end()) {
+                        const auto found = kmer_prg.find_node(prg::intern(v[j]));
+                        if (found == nullptr) {
                             num_AT = std::count(kmer.begin(), kmer.end(), 'A') +
                                      std::count(kmer.begin(), kmer.end(), 'T');
                             new_kn = kmer_prg.add_node_with_kh(v[j], std::min(kh.first, kh.second), num_AT);
@@ -491,20 +512,18 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
 
                             if (v.back().get_end() == (--(prg.nodes.end()))->second->pos.get_end()) {
                                 end_leaves.push_back(new_kn);
-                            } else if (find(current_leaves.begin(), current_leaves.end(), new_kn) ==
-                                       current_leaves.end()) {
+                            } else if (queued_leaves.insert(new_kn->id).second) {
                                 current_leaves.push_back(new_kn);
                             }
                             num_kmers_added += 1;
                         } else {
-                            kmer_prg.add_edge(old_kn, *found);
-                            old_kn = *found;
+                            kmer_prg.add_edge(old_kn, found);
+                            old_kn = found;
 
                             if (v.back().get_end() == (--(prg.nodes.end()))->second->pos.get_end()) {
-                                end_leaves.push_back(*found);
-                            } else if (find(current_leaves.begin(), current_leaves.end(), *found) ==
-                                       current_leaves.end()) {
-                                current_leaves.push_back(*found);
+                                end_leaves.push_back(found);
+                            } else if (queued_leaves.insert(found->id).second) {
+                                current_leaves.push_back(found);
                             }
                         }
                     }
@@ -537,6 +556,27 @@ void LocalPRG::minimizer_sketch(std::shared_ptr<Index> index, const uint32_t w,
            assert_msg("nodes.size(): " << kmer_prg.nodes.size() << " and num minikmers: " << num_kmers_added));
     kmer_prg.remove_shortcut_edges();
     kmer_prg.check();
+
+    BOOST_LOG_TRIVIAL(debug) << "Sketch of PRG " << name << " reused " << shift_memoization.hits << " of "
+                             << shift_memoization.hits + shift_memoization.misses << " shifts and "
+                             << walk_memoization.hits << " of " << walk_memoization.hits + walk_memoization.misses
+                             << " walks";
+    shift_memoization.clear();
+    walk_memoization.clear();
+}
+
+// loads kmer_prg if it was left to be loaded on demand, see load_PRG_kmergraphs_on_demand
+void LocalPRG::load_kmer_prg() {
+    if (kmer_prg_loader != nullptr)
+        kmer_prg_loader->load(*this);
+}
+
+// the min_path_length of kmer_prg, read from the index when possible so that kmer_prg need not be loaded
+uint32_t LocalPRG::min_path_length() {
+    if (kmer_prg_min_path_length > 0)
+        return kmer_prg_min_path_length;
+    load_kmer_prg();
+    return kmer_prg.min_path_length();
 }
 
 
@@ -564,13 +604,13 @@ LocalPRG::kmernode_path_from_localnode_path(const std::vector<LocalNodePtr> &loc
 
     for (const auto &n: kmer_prg.sorted_nodes) {
         for (const auto &interval : local_path.path) {
-            if (interval.start > n->path.get_end())
+            if (interval.start > n->path().get_end())
                 break;
-            else if (interval.get_end() < n->path.get_start())
+            else if (interval.get_end() < n->path().get_start())
                 continue;
-            else if ((intervals_overlap(interval, n->path.path[0]) or
-                      intervals_overlap(interval, n->path.path.back())) and not local_path.is_branching(n->path)) {
-                //and not n.second->path.is_branching(local_path))
+            else if ((intervals_overlap(interval, n->path().path[0]) or
+                      intervals_overlap(interval, n->path().path.back())) and not local_path.is_branching(n->path())) {
+                //and not n.second->path().is_branching(local_path))
                 kmernode_path.push_back(n);
                 break;
             }
@@ -590,11 +630,11 @@ LocalPRG::localnode_path_from_kmernode_path(const std::vector<KmerNodePtr> &kmer
         return localnode_path;
     std::vector<prg::Path> walk_paths;
     for (uint32_t i = 0; i != kmernode_path.size(); ++i) {
-        if (i != 0 and kmernode_path[i]->path.length() == 0) // only have null paths at beginning and end
+        if (i != 0 and kmernode_path[i]->path().length() == 0) // only have null paths at beginning and end
         {
             break;
         }
-        kmernode = nodes_along_path(kmernode_path[i]->path);
+        kmernode = nodes_along_path(kmernode_path[i]->path());
 
         // if the start of the new localnode path is after the end of the previous, join up WLOG with top path
         while (!localnode_path.empty() and !localnode_path.back()->outNodes.empty() and
@@ -719,15 +759,15 @@ get_covgs_along_localnode_path(const PanNodePtr pan_node, const std::vector<Loca
     // collect covgs
     uint32_t j = 0, k = 0, start = 0, end = 0;
     for (const auto &kmernode_ptr: kmernode_path) {
-        if (kmernode_ptr->path.length() == 0)
+        if (kmernode_ptr->path().length() == 0)
             continue;
 
-        while (j < localnode_path.size() and localnode_path[j]->pos.get_end() < kmernode_ptr->path.get_start()) {
+        while (j < localnode_path.size() and localnode_path[j]->pos.get_end() < kmernode_ptr->path().get_start()) {
             j++;
         }
 
         k = j;
-        for (const auto &interval : kmernode_ptr->path.path) {
+        for (const auto &interval : kmernode_ptr->path().path) {
                 assert(localnode_path[k]->pos.start <= interval.start and
                    localnode_path[k]->pos.get_end() >= interval.get_end());
 
@@ -1165,15 +1205,15 @@ void LocalPRG::append_kmer_covgs_in_range(const KmerGraph &kg, const std::vector
 
     // start by adding coverage before we get to first kmer
     uint32_t added = 0, k = 0;
-    //std::cout << "first kmer" << kmer_path[1]->path << std::endl;
+    //std::cout << "first kmer" << kmer_path[1]->path() << std::endl;
     for (const auto &n: local_path) {
         //std::cout << n->pos << " ";
         if (n->pos.length == 0) {
             continue;
-        } else if (n->pos.get_end() < kmer_path[1]->path.get_start()) {
+        } else if (n->pos.get_end() < kmer_path[1]->path().get_start()) {
             added += n->pos.length;
-        } else if (n->pos.get_end() >= kmer_path[1]->path.get_start() and n->pos.start < kmer_path[1]->path.get_end()) {
-            added += kmer_path[1]->path.get_start() - n->pos.start;
+        } else if (n->pos.get_end() >= kmer_path[1]->path().get_start() and n->pos.start < kmer_path[1]->path().get_end()) {
+            added += kmer_path[1]->path().get_start() - n->pos.start;
             break;
         }
     }
@@ -1181,25 +1221,25 @@ void LocalPRG::append_kmer_covgs_in_range(const KmerGraph &kg, const std::vector
     //std::cout << "added " << added << std::endl;
     KmerNodePtr prev = nullptr;
     for (const auto &n: kmer_path) {
-        //std::cout << n->path << " ";
-        if (n->path.length() == 0)
+        //std::cout << n->path() << " ";
+        if (n->path().length() == 0)
             continue;
         else if (prev != nullptr) {
-            auto prev_interval_it = prev->path.path.begin();
-            while (prev_interval_it->get_end() < n->path.get_start()) {
+            auto prev_interval_it = prev->path().path.begin();
+            while (prev_interval_it->get_end() < n->path().get_start()) {
                 added += prev_interval_it->length;
                 prev_interval_it++;
             }
-            added += n->path.get_start() - prev_interval_it->start;
+            added += n->path().get_start() - prev_interval_it->start;
         } else {
-            k = n->path.length();
+            k = n->path().length();
             //added += k;
         }
 
         //std::cout << "pos_from:" << pos_from << " < added + k:" << added + k << " and added: " << added << " < pos_to:" << pos_to << std::endl;
 
         if (pos_from <= added + k and added < pos_to) {
-            //std::cout << " add " << n->path << std::endl;
+            //std::cout << " add " << n->path() << std::endl;
             assert(n->id < kg.nodes.size() and kg.nodes[n->id] != nullptr);
             fwd_covgs.push_back(kg.nodes.at(n->id)->get_covg(0, sample_id));
             rev_covgs.push_back(kg.nodes.at(n->id)->get_covg(1, sample_id));
@@ -1309,7 +1349,7 @@ void LocalPRG::add_sample_covgs_to_vcf(VCF &vcf, const KmerGraph &kg, const std:
     std::vector<KmerNodePtr> ref_kmer_path = kmernode_path_from_localnode_path(ref_path);
     std::cout << "ref path: ";
     for (const auto &n : ref_kmer_path) {
-        std::cout << n->path << " ";
+        std::cout << n->path() << " ";
     }
     std::cout << std::endl;
 
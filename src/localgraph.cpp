@@ -135,7 +135,65 @@ void LocalGraph::read_gfa(const std::string &filepath) {
     }
 }
 
-std::vector<prg::Path> LocalGraph::walk(const uint32_t &node_id, const uint32_t &pos, const uint32_t &len) const { //node_id: where to start the walk, pos: the position in the node_id, len = k+w-1 -> the length that the walk has to go through - we are sketching kmers in a graph
+// Nodes are written in id order as their interval in the PRG string, followed by the out edges of every node, so that
+// decode can add them back in the order build_graph did and the interval tree is the same.
+void LocalGraph::encode(std::string &buffer) const {
+    encode_varint(buffer, nodes.size());
+    uint32_t id = 0;
+    for (const auto &node : nodes) {
+        assert(node.first == id++ or assert_msg("LocalGraph node ids are not consecutive from 0"));
+        encode_varint(buffer, node.second->pos.start);
+        encode_varint(buffer, node.second->pos.length);
+    }
+    for (const auto &node : nodes) {
+        encode_varint(buffer, node.second->outNodes.size());
+        for (const auto &out : node.second->outNodes)
+            encode_varint(buffer, out->id);
+    }
+}
+
+bool LocalGraph::decode(const char *&data, const char *end, const std::string &seq) {
+    assert(nodes.empty());
+    uint32_t num_nodes, start, length;
+    if (!decode_varint(data, end, num_nodes))
+        return false;
+    for (uint32_t id = 0; id != num_nodes; ++id) {
+        if (!decode_varint(data, end, start) or !decode_varint(data, end, length)
+            or start > seq.size() or length > seq.size() - start)
+            return false;
+        add_node(id, seq.substr(start, length), Interval(start, start + length));
+    }
+    for (uint32_t from = 0; from != num_nodes; ++from) {
+        uint32_t num_out, to;
+        if (!decode_varint(data, end, num_out))
+            return false;
+        for (uint32_t j = 0; j != num_out; ++j) {
+            if (!decode_varint(data, end, to) or to >= num_nodes)
+                return false;
+            add_edge(from, to);
+        }
+    }
+    intervalTree.index();
+    return true;
+}
+
+std::vector<prg::Path> LocalGraph::walk(const uint32_t &node_id, const uint32_t &pos, const uint32_t &len,
+                                        WalkCache *cache) const {
+    if (cache == nullptr)
+        return walk_core(node_id, pos, len, nullptr);
+
+    // nested sites reach the same node with the same length left along many paths, so the walks are shared
+    const WalkArgs args = {node_id, pos, len};
+    const auto memoized = cache->find(args);
+    if (memoized != nullptr)
+        return *memoized;
+    auto walk_paths = walk_core(node_id, pos, len, cache);
+    cache->insert(args, walk_paths);
+    return walk_paths;
+}
+
+std::vector<prg::Path> LocalGraph::walk_core(const uint32_t &node_id, const uint32_t &pos, const uint32_t &len,
+                                             WalkCache *cache) const { //node_id: where to start the walk, pos: the position in the node_id, len = k+w-1 -> the length that the walk has to go through - we are sketching kmers in a graph
     //cout << "walking graph from node " << node_id << " pos " << pos << " for length " << len << endl;
     // walks from position pos in node node for length len bases
     assert((nodes.at(node_id)->pos.start <= pos && nodes.at(node_id)->pos.get_end() >= pos) || assert_msg(
@@ -162,7 +220,7 @@ std::vector<prg::Path> LocalGraph::walk(const uint32_t &node_id, const uint32_t
         for (auto it = nodes.at(node_id)->outNodes.begin();
              it != nodes.at(node_id)->outNodes.end(); ++it) {
             //cout << "Following node: " << (*it)->id << " to add " << len-len_added << " more bases" << endl;
-            walk_paths = walk((*it)->id, (*it)->pos.start, len - len_added);
+            walk_paths = walk((*it)->id, (*it)->pos.start, len - len_added, cache);
             //cout << "walk paths size: " << walk_paths.size() << endl;
             for (auto &walk_path : walk_paths) {
                 // Note, would have just added start interval to each item in walk_paths, but can't seem to force result of it2 to be non-const
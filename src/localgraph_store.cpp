@@ -0,0 +1,143 @@
+#include <cstring>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+
+#include "localgraph_store.h"
+#include "localPRG.h"
+
+// Local graph store layout, integers in host byte order:
+//   LocalGraphStoreHeader
+//   graphs back to back in the order of the PRG file, each the uint32_t length and characters of the PRG name, the
+//   uint64_t hash and uint32_t length of the PRG string, followed by LocalGraph::encode
+//   padding to an 8 byte boundary
+//   uint64_t offsets[num_prgs + 1]   the graph of the i-th PRG is at [offsets[i], offsets[i+1])
+namespace {
+    const char store_magic[8] = {'P', 'A', 'N', 'D', 'L', 'G', 'S', '\0'};
+    const uint32_t store_version = 1;
+
+    struct LocalGraphStoreHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t num_prgs;
+        uint64_t table_offset;
+    };
+
+    static_assert(sizeof(LocalGraphStoreHeader) == 24, "unexpected padding in LocalGraphStoreHeader");
+
+    // FNV-1a, to notice a PRG file edited since its store was written
+    uint64_t hash_seq(const std::string &seq) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (const auto c : seq) {
+            hash ^= uint8_t(c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+LocalGraphStore::LocalGraphStore(const std::string &filepath) : filepath(filepath), valid(false), num_prgs(0),
+                                                                table_offset(0) {
+    LocalGraphStoreHeader header;
+    if (boost::filesystem::file_size(filepath) < sizeof(header) + sizeof(uint64_t)) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring truncated local graph store " << filepath;
+        return;
+    }
+    file.open(filepath);
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, store_magic, sizeof(store_magic)) != 0 or header.version != store_version) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring local graph store " << filepath << " which is not in format version "
+                                   << store_version;
+        return;
+    }
+    num_prgs = header.num_prgs;
+    table_offset = header.table_offset;
+    if (table_offset % sizeof(uint64_t) != 0
+        or table_offset + (uint64_t(num_prgs) + 1) * sizeof(uint64_t) != file.size()
+        or offset(num_prgs) > table_offset) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring local graph store " << filepath << " which has an inconsistent offset table";
+        return;
+    }
+    valid = true;
+}
+
+uint64_t LocalGraphStore::offset(const uint32_t i) const {
+    return reinterpret_cast<const uint64_t *>(file.data() + table_offset)[i];
+}
+
+std::shared_ptr<LocalPRG> LocalGraphStore::load(const uint32_t i, const uint32_t id, const std::string &name,
+                                                const std::string &seq) const {
+    if (!valid or i >= num_prgs)
+        return nullptr;
+    const char *data = file.data() + offset(i);
+    const char *end = file.data() + offset(i + 1);
+
+    uint32_t name_length, seq_length;
+    uint64_t seq_hash;
+    if (end - data < (long) sizeof(name_length))
+        return nullptr;
+    std::memcpy(&name_length, data, sizeof(name_length));
+    data += sizeof(name_length);
+    if (end - data < (long) (name_length + sizeof(seq_hash) + sizeof(seq_length))
+        or name.compare(0, std::string::npos, data, name_length) != 0)
+        return nullptr;
+    data += name_length;
+    std::memcpy(&seq_hash, data, sizeof(seq_hash));
+    data += sizeof(seq_hash);
+    std::memcpy(&seq_length, data, sizeof(seq_length));
+    data += sizeof(seq_length);
+    if (seq_length != seq.size() or seq_hash != hash_seq(seq))
+        return nullptr;
+
+    auto prg = std::make_shared<LocalPRG>(id, name, seq, false);
+    if (!prg->prg.decode(data, end, seq) or data != end) {
+        BOOST_LOG_TRIVIAL(warning) << "Local graph of PRG " << name << " in " << filepath << " is corrupt";
+        return nullptr;
+    }
+    return prg;
+}
+
+std::string localgraph_store_path(const std::string &prgfile) {
+    return prgfile + ".localgraphs.bin";
+}
+
+// Saves the local graphs of prgs, which are all the PRGs of a file in order, to filepath
+void save_localgraph_store(const std::vector<std::shared_ptr<LocalPRG>> &prgs, const std::string &filepath) {
+    std::ofstream handle(filepath, std::ios::binary | std::ios::trunc);
+    if (!handle.is_open()) {
+        BOOST_LOG_TRIVIAL(warning) << "Unable to open local graph store " << filepath << " for writing";
+        return;
+    }
+
+    LocalGraphStoreHeader header;
+    std::memcpy(header.magic, store_magic, sizeof(store_magic));
+    header.version = store_version;
+    header.num_prgs = prgs.size();
+    header.table_offset = 0;
+    handle.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::vector<uint64_t> offsets = {sizeof(header)};
+    offsets.reserve(prgs.size() + 1);
+    std::string buffer;
+    for (const auto &prg : prgs) {
+        buffer.clear();
+        const uint32_t name_length = prg->name.size(), seq_length = prg->seq.size();
+        const uint64_t seq_hash = hash_seq(prg->seq);
+        buffer.append(reinterpret_cast<const char *>(&name_length), sizeof(name_length));
+        buffer.append(prg->name);
+        buffer.append(reinterpret_cast<const char *>(&seq_hash), sizeof(seq_hash));
+        buffer.append(reinterpret_cast<const char *>(&seq_length), sizeof(seq_length));
+        prg->prg.encode(buffer);
+        handle.write(buffer.data(), buffer.size());
+        offsets.push_back(offsets.back() + buffer.size());
+    }
+
+    header.table_offset = (offsets.back() + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+    const char padding[sizeof(uint64_t)] = {0};
+    handle.write(padding, header.table_offset - offsets.back());
+    handle.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    handle.seekp(0);
+    handle.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    handle.close();
+}
@@ -22,6 +22,7 @@
 #include "pangenome/pangraph.h"
 #include "pangenome/pannode.h"
 #include "index.h"
+#include "read_index.h"
 #include "estimate_parameters.h"
 #include "noise_filtering.h"
 
@@ -43,6 +44,7 @@ static void show_map_usage() {
               << "\t-o,--outdir OUTDIR\tSpecify directory of output\n"
               << "\t-w W\t\t\t\tWindow size for (w,k)-minimizers, must be <=k, default 14\n"
               << "\t-k K\t\t\t\tK-mer size for (w,k)-minimizers, default 15\n"
+              << "\t-t,--threads T\t\t\tNumber of threads used to load the PRGs and map the reads, default 1\n"
               << "\t-m,--max_diff INT\t\tMaximum distance between consecutive hits within a cluster, default 500 (bps)\n"
               << "\t-e,--error_rate FLOAT\t\tEstimated error rate for reads, default 0.11\n"
               << "\t--genome_size\tNUM_BP\tEstimated length of genome, used for coverage estimation\n"
@@ -57,6 +59,10 @@ static void show_map_usage() {
               << "\t--clean\t\t\tAdd a step to clean and detangle the pangraph\n"
               << "\t--bin\t\t\tUse binomial model for kmer coverages, default is negative binomial\n"
               << "\t--max_covg\t\t\tMaximum average coverage from reads to accept\n"
+              << "\t--max_freq FLOAT|INT\t\tIgnore minimizers occurring more than INT times in the index, or the FLOAT\n"
+              << "\t\t\t\t\tfraction of most frequent minimizers if below 1, default 0 (keep all)\n"
+              << "\t--sort_merge_hits\t\tFind hits for a batch of reads at a time, by sorting their minimizers and\n"
+              << "\t\t\t\t\tmerging them with the index, which is faster for high coverage short reads\n"
               << "\t--genotype\t\t\tAdd extra step to carefully genotype sites\n"
               << "\t--snps_only\t\t\tWhen genotyping, include only snp sites\n"
               << "\t--discover\t\t\tAdd denovo discovery\n"
@@ -75,15 +81,15 @@ int pandora_map(int argc, char *argv[]) {
 
     // otherwise, parse the parameters from the command line
     string prgfile, reads_filepath, outdir = "pandora", vcf_refs_file, log_level="info";
-    uint32_t w = 14, k = 15, min_cluster_size = 10, genome_size = 5000000, max_covg = 300,
+    uint32_t w = 14, k = 15, min_cluster_size = 10, genome_size = 5000000, max_covg = 300, threads = 1,
             min_allele_covg_gt = 0, min_total_covg_gt = 0, min_diff_covg_gt = 0, min_kmer_covg=0; // default parameters
     uint16_t confidence_threshold = 1;
     uint_least8_t denovo_kmer_size{11};
     int max_diff = 250;
-    float e_rate = 0.11, min_allele_fraction_covg_gt = 0, genotyping_error_rate=0.01;
+    float e_rate = 0.11, min_allele_fraction_covg_gt = 0, genotyping_error_rate=0.01, max_freq = 0;
     bool output_kg = false, output_vcf = false;
     bool output_comparison_paths = false, output_mapped_read_fa = false;
-    bool illumina = false, clean = false;
+    bool illumina = false, clean = false, sort_merge_hits = false;
     bool output_covgs = false, bin = false;
     bool genotype = false, snps_only = false, discover_denovo = false;
     for (int i = 1; i < argc; ++i) {
@@ -126,6 +132,13 @@ int pandora_map(int argc, char *argv[]) {
                 std::cerr << "-k option requires one argument." << std::endl;
                 return 1;
             }
+        } else if ((arg == "-t") || (arg == "--threads")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                threads = (unsigned) atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--threads option requires one argument." << std::endl;
+                return 1;
+            }
         } else if ((arg == "-m") || (arg == "--max_diff")) {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
                 max_diff = atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
@@ -184,6 +197,15 @@ int pandora_map(int argc, char *argv[]) {
             clean = true;
         } else if ((arg == "--bin")) {
             bin = true;
+        } else if ((arg == "--sort_merge_hits")) {
+            sort_merge_hits = true;
+        } else if ((arg == "--max_freq")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                max_freq = static_cast<float>(atof(argv[++i])); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--max_freq option requires one argument." << std::endl;
+                return 1;
+            }
         } else if ((arg == "--max_covg")) {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
                 max_covg = atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
@@ -291,6 +313,9 @@ int pandora_map(int argc, char *argv[]) {
     cout << "\tclean\t" << clean << endl;
     cout << "\tbin\t" << bin << endl;
     cout << "\tmax_covg\t" << max_covg << endl;
+    cout << "\tmax_freq\t" << max_freq << endl;
+    cout << "\tsort_merge_hits\t" << sort_merge_hits << endl;
+    cout << "\tthreads\t" << threads << endl;
     cout << "\tgenotype\t" << genotype << endl;
     cout << "\tsnps_only\t" << snps_only << endl;
     cout << "\tdiscover\t" << discover_denovo << endl;
@@ -309,15 +334,20 @@ int pandora_map(int argc, char *argv[]) {
     cout << now() << "Loading Index and LocalPRGs from file" << endl;
     auto index = std::make_shared<Index>();
     index->load(prgfile, w, k);
+    index->mask_frequent_minimizers(max_freq);
     std::vector<std::shared_ptr<LocalPRG>> prgs;
-    read_prg_file(prgs, prgfile);
-    load_PRG_kmergraphs(prgs, w, k, prgfile);
+    read_prg_file(prgs, prgfile, 0, threads);
+    load_PRG_kmergraphs_on_demand(prgs, w, k, prgfile, *index);
 
     cout << now() << "Constructing pangenome::Graph from read file (this will take a while)" << endl;
     auto minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits(100000));
     auto pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    // reads are found again by id for denovo discovery and the mapped read output
+    const std::string read_index_filepath = discover_denovo or output_mapped_read_fa
+                                            ? read_index_path(reads_filepath, outdir) : "";
     uint32_t covg = pangraph_from_read_file(reads_filepath, minimizer_hits, pangraph, index, prgs, w, k, max_diff, e_rate,
-                                            min_cluster_size, genome_size, illumina, clean, max_covg);
+                                            min_cluster_size, genome_size, illumina, clean, max_covg, sort_merge_hits,
+                                            read_index_filepath, threads);
 
     cout << now() << "Finished with index, so clear " << endl;
     index->clear();
@@ -420,14 +450,14 @@ int pandora_map(int argc, char *argv[]) {
 
         for (auto &element : candidate_regions) {
             auto &candidate_region {element.second};
-            candidate_region.generate_read_pileup(reads_filepath);
+            candidate_region.generate_read_pileup(reads_filepath, read_index_filepath);
             denovo.find_paths_through_candidate_region(candidate_region);
             candidate_region.write_denovo_paths_to_file(denovo_output_directory);
         }
     }
 
     if (output_mapped_read_fa)
-        pangraph->save_mapped_read_strings(reads_filepath, outdir);
+        pangraph->save_mapped_read_strings(reads_filepath, outdir, 0, read_index_filepath);
 
     pangraph->clear();
 
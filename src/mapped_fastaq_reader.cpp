@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include "mapped_fastaq_reader.h"
+
+
+MappedFastaqReader::MappedFastaqReader(const std::string &filepath, ReadIndexBuilder *index) : index(index),
+                                                                                                pos(nullptr),
+                                                                                                end(nullptr),
+                                                                                                num_records(0) {
+    BOOST_LOG_TRIVIAL(debug) << "Open fastaq file " << filepath;
+    if (!boost::filesystem::is_regular_file(filepath)) {
+        std::cerr << "Unable to open fastaq file " << filepath << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    if (index != nullptr) {
+        index->gzipped = false;
+        index->read_offsets.clear();
+        index->checkpoints.clear();
+        index->windows.clear();
+    }
+    if (boost::filesystem::file_size(filepath) == 0) //which cannot be mapped
+        return;
+    file.open(filepath);
+    // the file is read through once, so the kernel can read ahead further and drop pages behind
+    madvise(const_cast<char *>(file.data()), file.size(), MADV_SEQUENTIAL);
+    pos = file.data();
+    end = file.data() + file.size();
+}
+
+boost::string_view MappedFastaqReader::next_line() {
+    const auto newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    boost::string_view line(pos, (newline != nullptr ? newline : end) - pos);
+    pos = newline != nullptr ? newline + 1 : end;
+    if (!line.empty() and line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+bool MappedFastaqReader::is_mapped(const boost::string_view &view) const {
+    return file.is_open() and view.data() >= file.data() and view.data() + view.size() <= file.data() + file.size();
+}
+
+// Parses lines as FastaqReader::parse does. Lines before the first name are skipped, and a record ends at the next
+// name outside of its quality, which is left for the next call.
+bool MappedFastaqReader::next(FastaqRecordView &record) {
+    const char *line_start;
+    boost::string_view line;
+    do {
+        if (pos == end)
+            return false;
+        line_start = pos;
+        line = next_line();
+    } while (line.empty() or (line[0] != '>' and line[0] != '@'));
+
+    record.id = num_records++;
+    if (index != nullptr)
+        index->read_offsets.push_back(line_start - file.data());
+    record.name = line.substr(1);
+    record.seq.clear();
+    uint32_t num_seq_lines = 0;
+    size_t quality_left = 0; //bases of the FASTQ record whose quality is yet to be skipped
+    bool first_quality_line = false;
+    while (pos != end) {
+        line_start = pos;
+        line = next_line();
+        if (quality_left > 0) {
+            if (first_quality_line or (!line.empty() and line[0] != '>' and line[0] != '@')) {
+                first_quality_line = false;
+                quality_left -= std::min(quality_left, line.size());
+                continue;
+            }
+            quality_left = 0;
+        }
+        if (line.empty()) {
+            continue;
+        } else if (line[0] == '>' or line[0] == '@') {
+            pos = line_start;
+            break;
+        } else if (line[0] == '+') {
+            quality_left = record.seq.size();
+            first_quality_line = true;
+        } else if (num_seq_lines++ == 0) {
+            record.seq = line;
+        } else {
+            if (num_seq_lines == 2)
+                joined_seq.assign(record.seq.data(), record.seq.size());
+            joined_seq.append(line.data(), line.size());
+            record.seq = joined_seq;
+        }
+    }
+    return true;
+}
@@ -16,6 +16,7 @@ static void show_index_usage() {
     std::cerr << "Usage: pandora merge_index <index1> <index2> ...\n"
               << "Options:\n"
               << "\t--outfile\t\t\t\tFilename for merged index\n"
+              << "\t--streaming\t\t\tMerge binary indexes on disk in bounded memory instead of loading them\n"
               << std::endl;
 }
 
@@ -30,6 +31,7 @@ int pandora_merge_index(int argc, char *argv[]) // the "pandora merge_index" com
     // otherwise, parse the parameters from the command line
     std::string outfile = "merged_index.idx";
     std::vector<std::string> indexes;
+    bool streaming = false;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if ((arg == "-h") || (arg == "--help")) {
@@ -42,6 +44,8 @@ int pandora_merge_index(int argc, char *argv[]) // the "pandora merge_index" com
                 std::cerr << "--outfile option requires one argument." << std::endl;
                 return 1;
             }
+        } else if (arg == "--streaming") {
+            streaming = true;
         } else {
             indexes.push_back(argv[i]);
         }
@@ -51,6 +55,11 @@ int pandora_merge_index(int argc, char *argv[]) // the "pandora merge_index" com
     boost::filesystem::path p(outfile);
     boost::filesystem::path dir = p.parent_path();
 
+    if (streaming) {
+        merge_index_files(indexes, outfile);
+        return 0;
+    }
+
     // merge indexes
     auto index = std::make_shared<Index>();
     for (const auto& new_index : indexes){
@@ -12,6 +12,8 @@
 
 #define assert_msg(x) !(std::cerr << "Assertion failed: " << x << std::endl)
 
+static const size_t hits_per_block = 4096;
+
 MinimizerHits::MinimizerHits(const uint32_t &num_hits) {
     uhits.reserve(num_hits);
 }
@@ -28,6 +30,7 @@ void MinimizerHits::clear() {
         delete c;
     }*/
     uhits.clear();
+    // the block is left to fill up, rather than reused, as hits of it may still be pointed to from another thread
 }
 
 MinimizerHits::~MinimizerHits() {
@@ -35,8 +38,12 @@ MinimizerHits::~MinimizerHits() {
 }
 
 void MinimizerHits::add_hit(const uint32_t i, const Minimizer &m, const MiniRecord *r) {
-    MinimizerHitPtr mh(std::make_shared<MinimizerHit>(i, m, r));
-    uhits.insert(mh);
+    if (block == nullptr or block->size() == block->capacity()) {
+        block = std::make_shared<std::vector<MinimizerHit>>();
+        block->reserve(hits_per_block);
+    }
+    block->emplace_back(i, m, r); //never reallocates, so earlier hits of the block stay put
+    uhits.emplace_back(block, &block->back());
 }
 
 void MinimizerHits::sort() {
@@ -53,7 +60,7 @@ void MinimizerHits::sort() {
 }
 
 /*std::ostream& operator<< (std::ostream & out, MinimizerHits const& m) {
-    out << "(" << m.read_id << ", " << m.read_start_position << ", " << m.prg_id << ", " << m.prg_path << ", " << strand << ")";
+    out << "(" << m.read_id << ", " << m.read_start_position << ", " << m.prg_id << ", " << m.prg_path() << ", " << strand << ")";
     return out ;
 }*/
 
@@ -74,21 +81,26 @@ bool pEq::operator()(const MinimizerHitPtr &lhs, const MinimizerHitPtr &rhs) con
     return hash<string>()(temp);
 }*/
 
-bool pComp_path::operator()(const MinimizerHitPtr &lhs, const MinimizerHitPtr &rhs) {
+bool pComp_path::operator()(const MinimizerHitPtr &lhs, const MinimizerHitPtr &rhs) const {
+    return (*this)(*lhs, *rhs);
+}
+
+bool pComp_path::operator()(const MinimizerHit &lhs, const MinimizerHit &rhs) const {
     // should be same id
-    if (lhs->prg_id < rhs->prg_id) { return true; }
-    if (rhs->prg_id < lhs->prg_id) { return false; }
+    if (lhs.prg_id < rhs.prg_id) { return true; }
+    if (rhs.prg_id < lhs.prg_id) { return false; }
     //want those that match against the same prg_path together
-    if (lhs->prg_path < rhs->prg_path) { return true; }
-    if (rhs->prg_path < lhs->prg_path) { return false; }
+    const auto &pool = prg::PathPool::instance();
+    if (pool.less(lhs.prg_path_id, rhs.prg_path_id)) { return true; }
+    if (pool.less(rhs.prg_path_id, lhs.prg_path_id)) { return false; }
     //separated into two categories, corresponding to a forward, and a rev-complement hit, note fwd come first
-    if (lhs->is_forward > rhs->is_forward) { return true; }
-    if (rhs->is_forward > lhs->is_forward) { return false; }
+    if (lhs.is_forward > rhs.is_forward) { return true; }
+    if (rhs.is_forward > lhs.is_forward) { return false; }
     // finally, make sure that hits from separate reads aren't removed from the set as "=="
-    if (lhs->read_id < rhs->read_id) { return true; }
-    if (rhs->read_id < lhs->read_id) { return false; }
-    if (lhs->read_start_position < rhs->read_start_position) { return true; }
-    if (rhs->read_start_position < lhs->read_start_position) { return false; }
+    if (lhs.read_id < rhs.read_id) { return true; }
+    if (rhs.read_id < lhs.read_id) { return false; }
+    if (lhs.read_start_position < rhs.read_start_position) { return true; }
+    if (rhs.read_start_position < lhs.read_start_position) { return false; }
     return false;
 }
 
@@ -101,8 +113,8 @@ bool clusterComp::operator()(std::set<MinimizerHitPtr, pComp> lhs, std::set<Mini
     if (rhs.size() > lhs.size()) { return false; }
     if ((*lhs.begin())->prg_id < (*rhs.begin())->prg_id) { return true; }
     if ((*rhs.begin())->prg_id < (*lhs.begin())->prg_id) { return false; }
-    if ((*lhs.begin())->prg_path < (*rhs.begin())->prg_path) { return true; }
-    if ((*rhs.begin())->prg_path < (*lhs.begin())->prg_path) { return false; }
+    if ((*lhs.begin())->prg_path() < (*rhs.begin())->prg_path()) { return true; }
+    if ((*rhs.begin())->prg_path() < (*lhs.begin())->prg_path()) { return false; }
     if ((*lhs.begin())->is_forward < (*rhs.begin())->is_forward) { return true; }
     if ((*rhs.begin())->is_forward < (*lhs.begin())->is_forward) { return false; }
     return false;
@@ -117,8 +129,8 @@ bool clusterComp_size::operator()(std::set<MinimizerHitPtr, pComp> lhs, std::set
     if ((*rhs.begin())->read_start_position < (*lhs.begin())->read_start_position) { return false; }
     if ((*lhs.begin())->prg_id < (*rhs.begin())->prg_id) { return true; }
     if ((*rhs.begin())->prg_id < (*lhs.begin())->prg_id) { return false; }
-    if ((*lhs.begin())->prg_path < (*rhs.begin())->prg_path) { return true; }
-    if ((*rhs.begin())->prg_path < (*lhs.begin())->prg_path) { return false; }
+    if ((*lhs.begin())->prg_path() < (*rhs.begin())->prg_path()) { return true; }
+    if ((*rhs.begin())->prg_path() < (*lhs.begin())->prg_path()) { return false; }
     if ((*lhs.begin())->is_forward < (*rhs.begin())->is_forward) { return true; }
     if ((*rhs.begin())->is_forward < (*lhs.begin())->is_forward) { return false; }
     return false;
@@ -26,10 +26,6 @@ pangenome::Graph::Graph() : next_id(0) {
     nodes.reserve(6000);
 }
 
-void pangenome::Graph::reserve_num_reads(uint32_t &num_reads) {
-    reads.reserve(num_reads);
-}
-
 void pangenome::Graph::clear() {
     reads.clear();
     nodes.clear();
@@ -337,6 +333,7 @@ void pangenome::Graph::setup_kmergraphs(const std::vector<std::shared_ptr<LocalP
 
         BOOST_LOG_TRIVIAL(debug) << "setup kmergraphs for node " << pangraph_node.get_name();
         assert(pangraph_node.prg_id < prgs.size());
+        prgs[pangraph_node.prg_id]->load_kmer_prg();
         pangraph_node.kmer_prg = prgs[pangraph_node.prg_id]->kmer_prg;
         pangraph_node.kmer_prg.setup_coverages(total_number_samples);
     }
@@ -356,9 +353,7 @@ void pangenome::Graph::add_hits_to_kmergraphs(const std::vector<std::shared_ptr<
         for (const auto &read_ptr: pangraph_node.reads) {
             const Read &read = *read_ptr;
 
-            for (const auto &minimizer_hit_ptr: read.hits.at(pangraph_node.prg_id)) {
-                const auto &minimizer_hit = *minimizer_hit_ptr;
-
+            for (const auto &minimizer_hit: read.hits.at(pangraph_node.prg_id)) {
                 assert(minimizer_hit.kmer_node_id < pangraph_node.kmer_prg.nodes.size());
                 assert(pangraph_node.kmer_prg.nodes[minimizer_hit.kmer_node_id] != nullptr);
 
@@ -516,10 +511,11 @@ void pangenome::Graph::save_matrix(const std::string &filepath) {
     }
 }
 
-void pangenome::Graph::save_mapped_read_strings(const std::string &readfilepath, const std::string &outdir, const int32_t buff) {
+void pangenome::Graph::save_mapped_read_strings(const std::string &readfilepath, const std::string &outdir, const int32_t buff,
+                                                const std::string &read_index_filepath) {
     BOOST_LOG_TRIVIAL(debug) << "Save mapped read strings and coordinates";
     std::ofstream outhandle;
-    FastaqHandler readfile(readfilepath);
+    FastaqHandler readfile(readfilepath, read_index_filepath);
     uint32_t start, end;
 
     // for each node in pangraph, find overlaps and write to a file
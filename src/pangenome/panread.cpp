@@ -19,12 +19,22 @@ using namespace pangenome;
 Read::Read(const uint32_t i) : id(i) {}
 
 void Read::add_hits(const uint32_t prg_id, std::set<MinimizerHitPtr, pComp> &cluster) {
-    if (hits.find(prg_id) == hits.end())
-        hits[prg_id] = {};
-
-    auto before_size = hits[prg_id].size();
-    hits[prg_id].insert(cluster.begin(), cluster.end());
-    assert(hits[prg_id].size() == before_size + cluster.size());
+    // hits are copied out of the cluster, so the read keeps 24 bytes a hit and none of the cluster's allocations
+    auto &prg_hits = hits[prg_id];
+    const auto before_size = prg_hits.size();
+    if (prg_hits.empty())
+        prg_hits.reserve(cluster.size());
+    for (const auto &hit_ptr : cluster)
+        prg_hits.push_back(*hit_ptr);
+
+    const pComp_path comp;
+    std::sort(prg_hits.begin() + before_size, prg_hits.end(), comp);
+    std::inplace_merge(prg_hits.begin(), prg_hits.begin() + before_size, prg_hits.end(), comp);
+    // a hit already added is kept once, as it was when the hits of a read were a set
+    prg_hits.erase(std::unique(prg_hits.begin(), prg_hits.end(), [&comp](const MinimizerHit &lhs, const MinimizerHit &rhs) {
+        return !comp(lhs, rhs);
+    }), prg_hits.end());
+    assert(prg_hits.size() == before_size + cluster.size());
 }
 
 // find the index i in the nodes and node_orientations vectors such that [i,i+v.size()]
@@ -283,3 +283,12 @@ Path prg::get_union(const Path &x, const Path &y) {
     }
     return p;
 }
+
+size_t std::hash<prg::Path>::operator()(const prg::Path &p) const {
+    size_t seed = p.path.size();
+    for (const auto &interval : p.path) {
+        seed ^= interval.start + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= interval.length + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
@@ -0,0 +1,76 @@
+#include <cassert>
+#include <limits>
+#include <iostream>
+#include "prg/path_pool.h"
+
+
+#define assert_msg(x) !(std::cerr << "Assertion failed: " << x << std::endl)
+
+
+using namespace prg;
+
+PathPool &PathPool::instance() {
+    static PathPool pool;
+    return pool;
+}
+
+PathPool::Shard::Shard() : num_paths(0), staged_hash(0), ids(16, IdHash{this}, IdEqual{this}) {
+    for (auto &chunk : chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+}
+
+PathPool::Shard::~Shard() {
+    for (auto &chunk : chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+size_t PathPool::IdHash::operator()(const uint32_t local) const {
+    if (local == shard->num_paths)
+        return shard->staged_hash;
+    return std::hash<Path>()(shard->get(local));
+}
+
+bool PathPool::IdEqual::operator()(const uint32_t lhs, const uint32_t rhs) const {
+    return lhs == rhs or shard->get(lhs) == shard->get(rhs);
+}
+
+Path &PathPool::Shard::slot(const uint32_t local) {
+    const uint32_t position = local + (1u << first_chunk_bits);
+    const uint32_t c = 31 - __builtin_clz(position) - first_chunk_bits;
+    auto &chunk = chunks[c];
+    if (chunk.load(std::memory_order_relaxed) == nullptr)
+        chunk.store(new Path[size_t(1) << (c + first_chunk_bits)], std::memory_order_release);
+    return chunk.load(std::memory_order_relaxed)[position - (1u << (c + first_chunk_bits))];
+}
+
+PathId PathPool::intern(const Path &path) {
+    // the top bits of the mixed hash pick the shard, the set of the shard buckets on the hash itself
+    const size_t hash = std::hash<Path>()(path);
+    const uint32_t shard_id = (uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >> (64 - shard_bits);
+    auto &shard = shards[shard_id];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    assert(shard.num_paths < local_mask or assert_msg("Too many distinct paths for a PathId"));
+
+    // stage the path in the first free slot, so the set can compare it to the stored paths by position
+    shard.slot(shard.num_paths) = path;
+    shard.staged_hash = hash;
+    const auto it = shard.ids.find(shard.num_paths);
+    if (it != shard.ids.end())
+        return (shard_id << local_bits) | *it;
+    shard.ids.insert(shard.num_paths);
+    return (shard_id << local_bits) | shard.num_paths++;
+}
+
+bool PathPool::less(const PathId lhs, const PathId rhs) const {
+    return lhs != rhs and get(lhs) < get(rhs);
+}
+
+size_t PathPool::size() const {
+    size_t num_paths = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        num_paths += shard.num_paths;
+    }
+    return num_paths;
+}
@@ -13,21 +13,37 @@
 
 int pandora_random_path(int argc, char *argv[]) // the "pandora walk" comand
 {
-    if (argc != 3 and argc != 2) {
-        fprintf(stderr, "Usage: pandora random_path <in_prg.fa> [<num_paths>]\n");
+    // options may come before or between the arguments
+    std::vector<std::string> args;
+    uint32_t threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-t") || (arg == "--threads")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                threads = (unsigned) atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--threads option requires one argument." << std::endl;
+                return 1;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.size() != 2 and args.size() != 1) {
+        fprintf(stderr, "Usage: pandora random_path [-t <threads>] <in_prg.fa> [<num_paths>]\n");
         return 1;
     }
 
     // load prgs
     std::vector<std::shared_ptr<LocalPRG>> prgs;
-    read_prg_file(prgs, argv[1]);
+    read_prg_file(prgs, args[0], 0, threads);
 
     // create fasta
     Fastaq fa(true, false);
 
     uint32_t num_paths = 1;
-    if (argc == 3) {
-        num_paths = atoi(argv[2]);
+    if (args.size() == 2) {
+        num_paths = atoi(args[1].c_str());
     }
 
     for (const auto &prg_ptr: prgs) {
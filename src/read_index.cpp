@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+
+#include "read_index.h"
+
+// Read index layout, integers in host byte order:
+//   ReadIndexHeader
+//   uint64_t read_offsets[num_reads]
+//   GzipCheckpoint checkpoints[num_checkpoints]   in increasing order of offset, the first at the start of the file
+//   char windows[windows_size]
+// Gzip checkpoints are those of zlib's zran example, where decompression can restart from the end of a deflate block
+// given the bits of the block left in its last byte and the 32 KiB decompressed before it.
+namespace {
+    const char index_magic[8] = {'P', 'A', 'N', 'D', 'R', 'I', 'X', '\0'};
+    const uint32_t index_version = 1;
+    const size_t gzip_window_size = 1 << 15;
+
+    struct ReadIndexHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t gzipped;
+        uint64_t read_file_size;
+        int64_t read_file_write_time;
+        uint64_t num_reads;
+        uint64_t num_checkpoints;
+        uint64_t windows_size;
+    };
+
+    static_assert(sizeof(ReadIndexHeader) == 56, "unexpected padding in ReadIndexHeader");
+    static_assert(sizeof(GzipCheckpoint) == 32, "unexpected padding in GzipCheckpoint");
+}
+
+std::string read_index_path(const std::string &readfile, const std::string &dir) {
+    return (boost::filesystem::path(dir) / (boost::filesystem::path(readfile).filename().string() + ".read_index.bin"))
+            .string();
+}
+
+// Saves the index of the reads of readfile to filepath
+void ReadIndexBuilder::save(const std::string &readfile, const std::string &filepath) const {
+    std::ofstream handle(filepath, std::ios::binary | std::ios::trunc);
+    if (!handle.is_open()) {
+        BOOST_LOG_TRIVIAL(warning) << "Unable to open read index " << filepath << " for writing";
+        return;
+    }
+
+    ReadIndexHeader header;
+    std::memcpy(header.magic, index_magic, sizeof(index_magic));
+    header.version = index_version;
+    header.gzipped = gzipped;
+    header.read_file_size = boost::filesystem::file_size(readfile);
+    header.read_file_write_time = boost::filesystem::last_write_time(readfile);
+    header.num_reads = read_offsets.size();
+    header.num_checkpoints = checkpoints.size();
+    header.windows_size = windows.size();
+    handle.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    handle.write(reinterpret_cast<const char *>(read_offsets.data()), read_offsets.size() * sizeof(uint64_t));
+    handle.write(reinterpret_cast<const char *>(checkpoints.data()), checkpoints.size() * sizeof(GzipCheckpoint));
+    handle.write(windows.data(), windows.size());
+    handle.close();
+    BOOST_LOG_TRIVIAL(debug) << "Saved offsets of " << read_offsets.size() << " reads to " << filepath;
+}
+
+ReadIndex::ReadIndex(const std::string &readfile, const std::string &filepath)
+        : valid(false), gzipped(false), num_reads_indexed(0), read_offsets(nullptr), checkpoints(nullptr),
+          num_checkpoints(0), windows(nullptr) {
+    ReadIndexHeader header;
+    if (!boost::filesystem::is_regular_file(readfile) or !boost::filesystem::exists(filepath)
+        or boost::filesystem::file_size(filepath) < sizeof(header))
+        return;
+    file.open(filepath);
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, index_magic, sizeof(index_magic)) != 0 or header.version != index_version) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring read index " << filepath << " which is not in format version "
+                                   << index_version;
+        return;
+    }
+    if (header.read_file_size != boost::filesystem::file_size(readfile)
+        or header.read_file_write_time != boost::filesystem::last_write_time(readfile)) {
+        BOOST_LOG_TRIVIAL(debug) << "Ignoring read index " << filepath << " as " << readfile << " has changed since";
+        return;
+    }
+    if (header.num_reads > std::numeric_limits<uint32_t>::max()
+        or sizeof(header) + header.num_reads * sizeof(uint64_t) + header.num_checkpoints * sizeof(GzipCheckpoint)
+           + header.windows_size != file.size()
+        or (header.gzipped and header.num_checkpoints == 0)) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring read index " << filepath << " which has inconsistent sizes";
+        return;
+    }
+    gzipped = header.gzipped;
+    num_reads_indexed = header.num_reads;
+    num_checkpoints = header.num_checkpoints;
+    read_offsets = reinterpret_cast<const uint64_t *>(file.data() + sizeof(header));
+    checkpoints = reinterpret_cast<const GzipCheckpoint *>(read_offsets + num_reads_indexed);
+    windows = reinterpret_cast<const char *>(checkpoints + num_checkpoints);
+    valid = true;
+}
+
+uint64_t ReadIndex::read_offset(const uint32_t id) const {
+    assert(id < num_reads_indexed);
+    return read_offsets[id];
+}
+
+const GzipCheckpoint &ReadIndex::checkpoint_before(const uint64_t offset) const {
+    assert(num_checkpoints > 0);
+    const auto it = std::upper_bound(checkpoints, checkpoints + num_checkpoints, offset,
+                                     [](const uint64_t offset, const GzipCheckpoint &checkpoint) {
+                                         return offset < checkpoint.uncompressed_offset;
+                                     });
+    return it == checkpoints ? *it : *(it - 1);
+}
+
+const char *ReadIndex::window(const GzipCheckpoint &checkpoint) const {
+    return windows + checkpoint.window_offset;
+}
+
+GzipInflater::GzipInflater(std::istream &file, ReadIndexBuilder *index) : file(file), index(index),
+                                                                          input(1 << 16), window(gzip_window_size),
+                                                                          window_pos(0), raw(false),
+                                                                          at_member_start(true), finished(false),
+                                                                          input_end(0), uncompressed_offset(0),
+                                                                          member_size(0), last_checkpoint(0) {
+    std::memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, 15 + 16) != Z_OK)
+        throw std::runtime_error("Unable to start gzip decompression");
+    if (index != nullptr)
+        add_checkpoint();
+}
+
+GzipInflater::GzipInflater(std::istream &file, const GzipCheckpoint &checkpoint, const char *checkpoint_window)
+        : file(file), index(nullptr), input(1 << 16), window(gzip_window_size), window_pos(0),
+          raw(!checkpoint.member_start), at_member_start(checkpoint.member_start), finished(false), input_end(0),
+          uncompressed_offset(checkpoint.uncompressed_offset), member_size(0), last_checkpoint(0) {
+    std::memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, raw ? -15 : 15 + 16) != Z_OK)
+        throw std::runtime_error("Unable to start gzip decompression");
+    input_end = checkpoint.compressed_offset - (checkpoint.bits ? 1 : 0);
+    file.clear();
+    file.seekg(input_end);
+    if (checkpoint.bits) {
+        const int c = file.get();
+        if (c == EOF)
+            throw std::runtime_error("Gzip checkpoint is past the end of the file");
+        input_end += 1;
+        inflatePrime(&strm, checkpoint.bits, c >> (8 - checkpoint.bits));
+    }
+    if (raw)
+        inflateSetDictionary(&strm, reinterpret_cast<const Bytef *>(checkpoint_window), checkpoint.window_size);
+}
+
+GzipInflater::~GzipInflater() {
+    inflateEnd(&strm);
+}
+
+// false at the end of the file
+bool GzipInflater::fill_input() {
+    file.read(reinterpret_cast<char *>(input.data()), input.size());
+    const auto num_read = file.gcount();
+    strm.next_in = input.data();
+    strm.avail_in = num_read;
+    input_end += num_read;
+    return num_read > 0;
+}
+
+size_t GzipInflater::read(char *buffer, const size_t size) {
+    size_t num_read = 0;
+    while (num_read < size and !finished) {
+        if (strm.avail_in == 0 and !fill_input()) {
+            if (!at_member_start)
+                throw std::runtime_error("Gzip file ends part way through");
+            finished = true;
+            break;
+        }
+
+        // decompress into the window and copy out from there, so that it holds the last 32 KiB for checkpoints
+        strm.next_out = window.data() + window_pos;
+        strm.avail_out = std::min(window.size() - window_pos, size - num_read);
+        const auto avail_out = strm.avail_out;
+        const int ret = inflate(&strm, Z_BLOCK);
+        if (ret != Z_OK and ret != Z_STREAM_END and ret != Z_BUF_ERROR)
+            throw std::runtime_error(std::string("Corrupt gzip file: ") + (strm.msg != nullptr ? strm.msg : "?"));
+        const size_t num_inflated = avail_out - strm.avail_out;
+        std::memcpy(buffer + num_read, window.data() + window_pos, num_inflated);
+        num_read += num_inflated;
+        window_pos = (window_pos + num_inflated) % window.size();
+        uncompressed_offset += num_inflated;
+        member_size += num_inflated;
+        at_member_start = false;
+
+        if (ret == Z_STREAM_END) {
+            // the next member, if any, is a gzip file of its own. Raw decompression leaves the 8 byte gzip trailer.
+            for (size_t trailer = raw ? 8 : 0; trailer > 0;) {
+                if (strm.avail_in == 0 and !fill_input())
+                    throw std::runtime_error("Gzip file ends part way through");
+                const auto skipped = std::min<size_t>(trailer, strm.avail_in);
+                strm.next_in += skipped;
+                strm.avail_in -= skipped;
+                trailer -= skipped;
+            }
+            raw = false;
+            inflateReset2(&strm, 15 + 16);
+            at_member_start = true;
+            member_size = 0;
+            if (index != nullptr and uncompressed_offset - last_checkpoint >= index->checkpoint_span)
+                add_checkpoint();
+        } else if (index != nullptr and (strm.data_type & 128) and !(strm.data_type & 64)
+                   and uncompressed_offset - last_checkpoint >= index->checkpoint_span) {
+            add_checkpoint();
+        }
+    }
+    return num_read;
+}
+
+void GzipInflater::add_checkpoint() {
+    GzipCheckpoint checkpoint;
+    checkpoint.uncompressed_offset = uncompressed_offset;
+    checkpoint.compressed_offset = input_end - strm.avail_in;
+    checkpoint.window_offset = index->windows.size();
+    checkpoint.window_size = at_member_start ? 0 : std::min<uint64_t>(member_size, window.size());
+    checkpoint.bits = at_member_start ? 0 : strm.data_type & 7;
+    checkpoint.member_start = at_member_start;
+
+    const auto *ring = reinterpret_cast<const char *>(window.data());
+    if (checkpoint.window_size > window_pos)
+        index->windows.append(ring + window.size() - (checkpoint.window_size - window_pos),
+                              checkpoint.window_size - window_pos);
+    index->windows.append(ring + window_pos - std::min<size_t>(window_pos, checkpoint.window_size),
+                          std::min<size_t>(window_pos, checkpoint.window_size));
+    index->checkpoints.push_back(checkpoint);
+    last_checkpoint = uncompressed_offset;
+}
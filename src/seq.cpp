@@ -16,7 +16,8 @@
 using std::vector;
 
 
-Seq::Seq(uint32_t i, std::string n, std::string p, uint32_t w, uint32_t k) : id(i), name(n), seq(p) {
+Seq::Seq(uint32_t i, std::string n, std::string p, uint32_t w, uint32_t k) : id(i), name(n), seq(p),
+                                                                           num_ambiguous_bases(0) {
     minimizer_sketch(w, k);
 }
 
@@ -24,99 +25,104 @@ Seq::~Seq() {
     sketch.clear();
 }
 
-void Seq::initialize(uint32_t i, std::string n, std::string p, uint32_t w, uint32_t k) {
+void Seq::initialize(uint32_t i, const boost::string_view &n, const boost::string_view &p, uint32_t w, uint32_t k) {
     id = i;
-    name = n;
-    seq = p;
+    name.assign(n.data(), n.size());
+    seq.assign(p.data(), p.size());
     sketch.clear();
     minimizer_sketch(w, k);
 }
 
-bool Seq::add_letter_to_get_next_kmer(const char &letter,
-                                      const uint64_t &shift1,
-                                      const uint64_t &mask,
-                                      uint32_t &buff,
-                                      uint64_t (&kmer)[2],
-                                      uint64_t (&kh)[2]) {
-    uint32_t c = nt4((uint8_t) letter);
-    if (c < 4) { // not an ambiguous base
-        kmer[0] = (kmer[0] << 2 | c) & mask;           // forward k-mer
-        kmer[1] = (kmer[1] >> 2) | (3ULL ^ c) << shift1; // reverse k-mer
-        kh[0] = hash64(kmer[0], mask);
-        kh[1] = hash64(kmer[1], mask);
-        buff++;
-        return true;
-    } else {
-        BOOST_LOG_TRIVIAL(debug) << now() << "bad letter - found a non AGCT base in read so skipping read " << name;
-        sketch.clear();
-        return false;
-    }
-}
-
-uint64_t find_smallest_kmer_value(const vector<Minimizer> &window, uint &pos_of_smallest) {
-    uint64_t smallest = std::numeric_limits<uint64_t>::max();
-    uint i = 0;
-    for (const auto &minimizer : window) {
-        if (minimizer.kmer <= smallest) {
-            smallest = minimizer.kmer;
-            pos_of_smallest = i;
+// Fills forward_kmers and reverse_kmers with the hashes of the forward and reverse complement kmers starting at each
+// position, and acgt_runs with the runs of seq between non ACGT bases. Kmers overlapping a non ACGT base are not
+// meaningful. The kmers are encoded in one pass over seq, then hashed together, which the CPU can vectorize.
+void Seq::hash_kmers(const uint32_t k, std::vector<Interval> &acgt_runs) {
+    const uint64_t shift1 = 2 * (k - 1), mask = (1ULL << 2 * k) - 1;
+    const size_t num_kmers = seq.length() - k + 1;
+    forward_kmers.resize(num_kmers);
+    reverse_kmers.resize(num_kmers);
+
+    uint64_t kmer[2] = {0, 0};
+    uint32_t run_start = 0;
+    for (uint32_t i = 0; i != seq.length(); ++i) {
+        const uint32_t c = seq_nt4_table[(uint8_t) seq[i]];
+        if (c < 4) { // not an ambiguous base
+            kmer[0] = (kmer[0] << 2 | c) & mask;           // forward k-mer
+            kmer[1] = (kmer[1] >> 2) | (3ULL ^ c) << shift1; // reverse k-mer
+        } else {
+            if (run_start < i)
+                acgt_runs.emplace_back(run_start, i);
+            run_start = i + 1;
+            num_ambiguous_bases++;
+            kmer[0] = kmer[1] = 0;
         }
-        i++;
-    }
-    return smallest;
-}
-
-void Seq::add_minimizing_kmers_to_sketch(const vector<Minimizer> &window, const uint64_t &smallest) {
-    for (const auto &minimizer : window) {
-        if (minimizer.kmer == smallest) {
-            sketch.insert(minimizer);
-            //num_minis_found += 1;
+        if (i + 1 >= k) {
+            forward_kmers[i + 1 - k] = kmer[0];
+            reverse_kmers[i + 1 - k] = kmer[1];
         }
     }
-}
-
-void Seq::minimize_window(vector<Minimizer> &window, uint64_t &smallest) {
-    uint pos_of_smallest;
-    smallest = find_smallest_kmer_value(window, pos_of_smallest);
-    add_minimizing_kmers_to_sketch(window, smallest);
-    window.erase(window.begin(), window.begin() + pos_of_smallest + 1);
-}
+    if (run_start < seq.length())
+        acgt_runs.emplace_back(run_start, seq.length());
 
-void Seq::add_new_smallest_minimizer(vector<Minimizer> &window, uint64_t &smallest) {
-    sketch.insert(window.back());
-    smallest = window.back().kmer;
-    window.clear();
+    hash64_batch(forward_kmers.data(), num_kmers, mask);
+    hash64_batch(reverse_kmers.data(), num_kmers, mask);
 }
 
+// Adds the minimizers of all windows of w consecutive kmers, which are every kmer equal to the smallest of a window.
+// Windows do not span non ACGT bases, so each run of ACGT bases between them is sketched as if it were a read.
+// The window keeps the positions of the kmers which are no larger than any kmer after them, in a ring buffer, so its
+// front is the smallest kmer of the window and is followed by any kmers equal to it. Its first num_in_sketch are
+// already sketched.
 void Seq::minimizer_sketch(const uint32_t w, const uint32_t k) {
+    num_ambiguous_bases = 0;
     bool sequence_too_short_to_sketch = seq.length() + 1 < w + k;
     if (sequence_too_short_to_sketch)
         return;
 
-    // initializations
-    uint64_t shift1 = 2 * (k - 1), mask = (1ULL << 2 * k) - 1,
-            smallest = std::numeric_limits<uint64_t>::max(),
-            kmer[2] = {0, 0}, kh[2] = {0, 0};
-    uint32_t buff = 0;
-    vector<Minimizer> window;
-    window.reserve(w);
-
-    for (const char letter : seq) {
-        bool added = add_letter_to_get_next_kmer(letter, shift1, mask, buff, kmer, kh);
-        if (not added)
-            return;
-
-        if (buff >= k) {
-            window.push_back(Minimizer(std::min(kh[0], kh[1]), buff - k, buff, (kh[0] <= kh[1])));
-        }
-
-        if (window.size() == w) {
-            minimize_window(window, smallest);
-        } else if (buff >= w + k and window.back().kmer <= smallest) {
-            add_new_smallest_minimizer(window, smallest);
+    std::vector<Interval> acgt_runs;
+    hash_kmers(k, acgt_runs);
+    if (num_ambiguous_bases > 0)
+        BOOST_LOG_TRIVIAL(debug) << now() << "found " << num_ambiguous_bases << " non AGCT bases in read " << name
+                                 << " so sketching the " << acgt_runs.size() << " runs of AGCT bases between them";
+
+    const size_t num_kmers = seq.length() - k + 1;
+    const auto kmer_hash = [this](const uint32_t i) { return std::min(forward_kmers[i], reverse_kmers[i]); };
+    uint32_t ring_size = 1;
+    while (ring_size < w)
+        ring_size <<= 1;
+    const uint32_t ring_mask = ring_size - 1; // so positions wrap with a mask rather than a division
+    vector<uint32_t> window(ring_size);
+    sketch.reserve(sketch.size() + 2 * num_kmers / (w + 1) + 1);
+
+    for (const auto &run : acgt_runs) {
+        if (run.length + 1 < w + k)
+            continue;
+        const uint32_t first_kmer = run.start, end_kmer = run.get_end() + 1 - k;
+        uint32_t front = 0, window_size = 0, num_in_sketch = 0;
+        for (uint32_t i = first_kmer; i != end_kmer; ++i) {
+            const uint64_t kh = kmer_hash(i);
+            if (window_size > 0 and window[front] + w <= i) { // front has left the window
+                front = (front + 1) & ring_mask;
+                window_size--;
+                num_in_sketch -= (num_in_sketch > 0);
+            }
+            while (window_size > 0 and kmer_hash(window[(front + window_size - 1) & ring_mask]) > kh) {
+                window_size--;
+            }
+            num_in_sketch = std::min(num_in_sketch, window_size);
+            window[(front + window_size) & ring_mask] = i;
+            window_size++;
+
+            if (i + 1 < first_kmer + w) // first window not full yet
+                continue;
+            const uint64_t smallest = kmer_hash(window[front]);
+            while (num_in_sketch < window_size
+                   and kmer_hash(window[(front + num_in_sketch) & ring_mask]) == smallest) {
+                const uint32_t j = window[(front + num_in_sketch) & ring_mask];
+                sketch.push_back(Minimizer(smallest, j, j + k, (forward_kmers[j] <= reverse_kmers[j])));
+                num_in_sketch++;
+            }
         }
-        assert(window.size() < w ||
-               assert_msg("we can't have added a smallest kmer correctly as window still has size " << window.size()));
     }
     //cout << now() << "Sketch size " << sketch.size() << " for read " << name << endl;
 }
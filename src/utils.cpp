@@ -12,6 +12,13 @@
 #include <memory>
 #include <ctime>
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
 #include <boost/filesystem.hpp>
 
 #include "utils.h"
@@ -22,6 +29,11 @@
 #include "noise_filtering.h"
 #include "minihit.h"
 #include "fastaq_handler.h"
+#include "bounded_queue.h"
+#include "fastaq_reader.h"
+#include "mapped_fastaq_reader.h"
+#include "kmergraph_store.h"
+#include "localgraph_store.h"
 
 
 #define assert_msg(x) !(std::cerr << "Assertion failed: " << x << std::endl)
@@ -104,25 +116,123 @@ float lognchoosek2(uint32_t n, uint32_t k1, uint32_t k2) {
     return total;
 }
 
+// unsigned LEB128, for the compact binary forms of the kmer and local graphs in which most numbers are small
+void encode_varint(std::string &buffer, uint32_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(char(value));
+}
+
+bool decode_varint(const char *&data, const char *end, uint32_t &value) {
+    value = 0;
+    for (uint32_t shift = 0; data != end and shift < 35; shift += 7) {
+        const auto byte = uint8_t(*data++);
+        value |= uint32_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Reads the PRGs of a file into prgs, with consecutive ids from id. With several threads the file is still read in
+// order by the calling thread while the others build the LocalPRGs, which are put in prgs in the order of the file.
 void read_prg_file(std::vector<std::shared_ptr<LocalPRG>> &prgs,
-                   const std::string &filepath, uint32_t id) {
+                   const std::string &filepath, uint32_t id, const uint32_t threads) {
     BOOST_LOG_TRIVIAL(debug) << "Loading PRGs from file " << filepath;
 
-    FastaqHandler fh(filepath);
-    while (!fh.eof()) {
-        fh.get_next();
-        if (fh.name.empty() or fh.read.empty())
-            continue;
-        auto s = std::make_shared<LocalPRG>(LocalPRG(id, fh.name, fh.read)); //build a node in the graph, which will represent a LocalPRG (the graph is a list of nodes, each representing a LocalPRG)
-        if (s != nullptr) {
-            prgs.push_back(s);
-            id++;
-        } else {
-            std::cerr << "Failed to make LocalPRG for " << fh.name << std::endl;
+    // the local graphs written by pandora index, if any, save building them from the PRG strings
+    std::unique_ptr<LocalGraphStore> store;
+    const auto store_path = localgraph_store_path(filepath);
+    if (boost::filesystem::exists(store_path))
+        store.reset(new LocalGraphStore(store_path));
+    std::atomic<uint32_t> num_from_store(0);
+
+    // makes the i-th PRG of the file
+    auto make_prg = [&](const uint32_t i, const std::string &name, const std::string &seq) {
+        std::shared_ptr<LocalPRG> s;
+        if (store != nullptr)
+            s = store->load(i, id + i, name, seq);
+        if (s != nullptr)
+            num_from_store++;
+        else
+            s = std::make_shared<LocalPRG>(LocalPRG(id + i, name, seq)); //build a node in the graph, which will represent a LocalPRG (the graph is a list of nodes, each representing a LocalPRG)
+        if (s == nullptr) {
+            std::cerr << "Failed to make LocalPRG for " << name << std::endl;
             exit(1);
         }
+        return s;
+    };
+
+    const auto first = prgs.size();
+    uint32_t num_read = 0;
+    FastaqReader reader(filepath);
+    std::vector<FastaqRecord> records;
+    if (threads <= 1) {
+        while (reader.next_batch(records)) {
+            for (const auto &record : records) {
+                if (record.name.empty() or record.seq.empty())
+                    continue;
+                prgs.push_back(make_prg(num_read++, record.name, record.seq));
+            }
+        }
+    } else {
+        // records wait in a bounded queue for a free thread, which puts the LocalPRG in its place in prgs
+        std::deque<std::tuple<uint32_t, std::string, std::string>> queue;
+        const size_t max_queued = 4 * threads;
+        bool finished_reading = false;
+        std::mutex queue_mutex;
+        std::condition_variable queue_changed;
+
+        auto build_prgs = [&]() {
+            while (true) {
+                std::tuple<uint32_t, std::string, std::string> record;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_changed.wait(lock, [&]() { return !queue.empty() or finished_reading; });
+                    if (queue.empty())
+                        return;
+                    record = std::move(queue.front());
+                    queue.pop_front();
+                }
+                queue_changed.notify_all();
+                auto s = make_prg(std::get<0>(record), std::get<1>(record), std::get<2>(record));
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                prgs[first + std::get<0>(record)] = s;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (uint32_t t = 0; t != threads; ++t)
+            workers.emplace_back(build_prgs);
+
+        while (reader.next_batch(records)) {
+            for (auto &record : records) {
+                if (record.name.empty() or record.seq.empty())
+                    continue;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_changed.wait(lock, [&]() { return queue.size() < max_queued; });
+                    prgs.emplace_back();
+                    queue.emplace_back(num_read++, std::move(record.name), std::move(record.seq));
+                }
+                queue_changed.notify_all();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            finished_reading = true;
+        }
+        queue_changed.notify_all();
+
+        for (auto &worker : workers)
+            worker.join();
     }
     BOOST_LOG_TRIVIAL(debug) << "Number of LocalPRGs read: " << prgs.size();
+    if (store != nullptr and num_from_store < num_read)
+        BOOST_LOG_TRIVIAL(info) << "Built " << num_read - num_from_store << " of " << num_read << " local graphs as "
+                                << store_path << " does not match them. Rerun pandora index to update it";
 }
 
 void load_PRG_kmergraphs(std::vector<std::shared_ptr<LocalPRG>> &prgs, const uint32_t &w, const uint32_t &k,
@@ -136,9 +246,17 @@ void load_PRG_kmergraphs(std::vector<std::shared_ptr<LocalPRG>> &prgs, const uin
     }
     //cout << "prefix for kmerprgs dir is " << prefix << endl;
 
+    std::vector<bool> loaded(prgs.size(), false);
+    const auto num_loaded = load_kmergraph_stores(prgs, loaded, prefix + "kmer_prgs", w, k);
+    BOOST_LOG_TRIVIAL(debug) << "Loaded " << num_loaded << " kmer_prgs from kmer graph stores";
+    if (num_loaded == prgs.size())
+        return;
+
+    // indexes from older versions of pandora have a GFA file for each PRG
     auto dir_num = 0;
     std::string dir;
-    for (const auto &prg: prgs) {
+    for (uint32_t i = 0; i != prgs.size(); ++i) {
+        const auto &prg = prgs[i];
         //cout << "Load kmergraph for " << prg->name << endl;
         if (prg->id % 4000 == 0) {
             dir = prefix + "kmer_prgs/" + int_to_string(dir_num + 1);
@@ -147,43 +265,156 @@ void load_PRG_kmergraphs(std::vector<std::shared_ptr<LocalPRG>> &prgs, const uin
             if (not boost::filesystem::exists(p))
                 dir = prefix + "kmer_prgs";
         }
+        if (loaded[i])
+            continue;
         prg->kmer_prg.load(dir + "/" + prg->name + ".k" + std::to_string(k) + ".w" + std::to_string(w) + ".gfa");
     }
 }
 
+// Defers loading the kmer graph of each PRG until it is needed, which for most PRGs is never as they get no hits. The
+// min_path_length used when clustering hits is taken from the index instead.
+void load_PRG_kmergraphs_on_demand(std::vector<std::shared_ptr<LocalPRG>> &prgs, const uint32_t &w, const uint32_t &k,
+                                   const std::string &prgfile, const Index &index) {
+    std::string prefix = "";
+    size_t pos = prgfile.find_last_of("/");
+    if (pos != std::string::npos) {
+        prefix += prgfile.substr(0, pos);
+        prefix += "/";
+    }
+
+    uint32_t num_prgs = 0;
+    for (const auto &prg : prgs)
+        num_prgs = std::max(num_prgs, prg->id + 1);
+    auto loader = std::make_shared<KmerGraphLoader>(prefix + "kmer_prgs", w, k, num_prgs);
+    for (const auto &prg : prgs) {
+        prg->kmer_prg_loader = loader;
+        if (prg->id < index.min_path_lengths.size())
+            prg->kmer_prg_min_path_length = index.min_path_lengths[prg->id];
+    }
+}
+
 void load_vcf_refs_file(const std::string &filepath, VCFRefs &vcf_refs) {
     BOOST_LOG_TRIVIAL(info) << "Loading VCF refs from file " << filepath;
 
-    FastaqHandler fh(filepath);
-    while (!fh.eof()) {
-        fh.get_next();
-        if (!fh.name.empty() && !fh.read.empty()) {
-            vcf_refs[fh.name] = fh.read;
+    FastaqReader reader(filepath);
+    std::vector<FastaqRecord> records;
+    while (reader.next_batch(records)) {
+        for (auto &record : records) {
+            if (!record.name.empty() && !record.seq.empty()) {
+                vcf_refs[record.name] = std::move(record.seq);
+            }
         }
     }
 }
 
 //void add_read_hits(const uint32_t id, const string& name, const string& seq, MinimizerHits* hits, Index* idx, const uint32_t w, const uint32_t k)
-void add_read_hits(std::shared_ptr<Seq> sequence,
-                   std::shared_ptr<MinimizerHits> minimizer_hits,
-                   std::shared_ptr<Index> index) {
-    //cout << now() << "Search for hits for read " << s->name << " which has sketch size " << s->sketch.size() << " against index of size " << idx->minhash.size() << endl;
-    uint32_t hit_count = 0;
+uint32_t add_read_hits(std::shared_ptr<Seq> sequence,
+                       std::shared_ptr<MinimizerHits> minimizer_hits,
+                       std::shared_ptr<Index> index) {
+    //cout << now() << "Search for hits for read " << s->name << " which has sketch size " << s->sketch.size() << " against index of size " << idx->num_keys() << endl;
+    uint32_t hit_count = 0, num_masked = 0;
     // creates Seq object for the read, then looks up minimizers in the Seq sketch and adds hits to a global MinimizerHits object
     //Seq s(id, name, seq, w, k);
-    for (auto it = sequence->sketch.begin(); it != sequence->sketch.end(); ++it) {
-        if (index->minhash.find((*it).kmer) != index->minhash.end()) {
-            for (uint32_t j = 0; j != index->minhash[(*it).kmer]->size(); ++j) {
-                minimizer_hits->add_hit(sequence->id, *it, &(index->minhash[(*it).kmer]->operator[](j)));
-                hit_count += 1;
-            }
-            //} else {
-            //    cout << "did not find minimizer " << (*it).kmer << " in index" << endl;
+    std::vector<uint64_t> kmers;
+    kmers.reserve(sequence->sketch.size());
+    for (const auto &minimizer : sequence->sketch)
+        kmers.push_back(minimizer.kmer);
+    std::vector<MiniRecordSpan> spans;
+    index->find(kmers, spans);
+    for (size_t i = 0; i != spans.size(); ++i) {
+        if (index->is_masked(spans[i])) {
+            num_masked += 1;
+            continue;
+        }
+        for (const auto &record : spans[i]) {
+            minimizer_hits->add_hit(sequence->id, sequence->sketch[i], &record);
+            hit_count += 1;
         }
     }
     //hits->sort();
     //cout << now() << "Found " << hit_count << " hits found for read " << s->name << " so size of MinimizerHits is now "
     //     << hits->hits.size() + hits->uhits.size() << endl;
+    return num_masked;
+}
+
+// a batch starts out assuming a hit for each minimizer
+ReadBatch::ReadBatch(const size_t max_hits) : max_hits(max_hits), max_minimizers(max_hits) {}
+
+void ReadBatch::add(const Seq &sequence) {
+    read_ids.insert(read_ids.end(), sequence.sketch.size(), sequence.id);
+    minimizers.insert(minimizers.end(), sequence.sketch.begin(), sequence.sketch.end());
+}
+
+bool ReadBatch::is_full() const {
+    return minimizers.size() >= max_minimizers;
+}
+
+// the number of hits of a minimizer depends on how repetitive the index is and where the reads are from, so varies
+// too much to bound the hits of a batch by its minimizers
+void ReadBatch::found_hits(const size_t num_hits) {
+    if (minimizers.empty())
+        return;
+    const double hits_per_minimizer = (double) std::max(num_hits, (size_t) 1) / minimizers.size();
+    max_minimizers = std::max((size_t) 1, (size_t) std::min(max_hits / hits_per_minimizer, (double) max_hits));
+}
+
+void ReadBatch::clear() {
+    read_ids.clear();
+    minimizers.clear();
+}
+
+// Stable least significant digit radix sort on the first of each pair, a byte at a time up to the highest byte which
+// is not zero in every key. Minimizers are hashes of at most 2k bits, so this takes 4 passes for k=15.
+void radix_sort(std::vector<std::pair<uint64_t, uint32_t>> &items) {
+    uint64_t bits_set = 0;
+    for (const auto &item : items)
+        bits_set |= item.first;
+    std::vector<std::pair<uint64_t, uint32_t>> sorted(items.size());
+    for (uint32_t shift = 0; shift < 64 and (bits_set >> shift) != 0; shift += 8) {
+        size_t counts[257] = {0};
+        for (const auto &item : items)
+            counts[((item.first >> shift) & 0xff) + 1]++;
+        for (uint32_t digit = 1; digit != 257; ++digit)
+            counts[digit] += counts[digit - 1];
+        for (const auto &item : items)
+            sorted[counts[(item.first >> shift) & 0xff]++] = item;
+        items.swap(sorted);
+    }
+}
+
+// Finds the hits of all the minimizers of a batch of reads by sorting them and merging them with the keys of the index.
+// With many reads of the same genomes each minimizer is looked up once for all its occurrences, and the index and its
+// records are read in order rather than at random.
+uint32_t add_read_batch_hits(const ReadBatch &batch,
+                             std::shared_ptr<MinimizerHits> minimizer_hits,
+                             std::shared_ptr<Index> index) {
+    std::vector<std::pair<uint64_t, uint32_t>> order;
+    order.reserve(batch.minimizers.size());
+    for (uint32_t i = 0; i != batch.minimizers.size(); ++i)
+        order.emplace_back(batch.minimizers[i].kmer, i);
+    radix_sort(order);
+
+    std::vector<uint64_t> kmers;
+    for (const auto &item : order) {
+        if (kmers.empty() or kmers.back() != item.first)
+            kmers.push_back(item.first);
+    }
+    std::vector<MiniRecordSpan> spans;
+    index->find_sorted(kmers, spans);
+
+    uint32_t num_masked = 0;
+    size_t j = 0;
+    for (const auto &item : order) {
+        if (kmers[j] != item.first)
+            ++j;
+        if (index->is_masked(spans[j])) {
+            num_masked += 1;
+            continue;
+        }
+        for (const auto &record : spans[j])
+            minimizer_hits->add_hit(batch.read_ids[item.second], batch.minimizers[item.second], &record);
+    }
+    return num_masked;
 }
 
 void define_clusters(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &clusters_of_hits,
@@ -208,11 +439,11 @@ void define_clusters(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &cl
             (*mh_current)->is_forward != (*mh_previous)->is_forward or
             (abs((int) (*mh_current)->read_start_position - (int) (*mh_previous)->read_start_position)) > max_diff) {
             // keep clusters which cover at least 1/2 the expected number of minihits
-            length_based_threshold = std::min(prgs[(*mh_previous)->prg_id]->kmer_prg.min_path_length(),
+            length_based_threshold = std::min(prgs[(*mh_previous)->prg_id]->min_path_length(),
                                               expected_number_kmers_in_short_read_sketch) *
                                      fraction_kmers_required_for_cluster;
             BOOST_LOG_TRIVIAL(debug) << "Length based cluster threshold min("
-                                     << prgs[(*mh_previous)->prg_id]->kmer_prg.min_path_length() << ", "
+                                     << prgs[(*mh_previous)->prg_id]->min_path_length() << ", "
                                      << expected_number_kmers_in_short_read_sketch << ") * "
                                      << fraction_kmers_required_for_cluster << " = " << length_based_threshold;
 
@@ -230,10 +461,10 @@ void define_clusters(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &cl
         current_cluster.insert(*mh_current);
         mh_previous = mh_current;
     }
-    length_based_threshold = std::min(prgs[(*mh_previous)->prg_id]->kmer_prg.min_path_length(),
+    length_based_threshold = std::min(prgs[(*mh_previous)->prg_id]->min_path_length(),
                                       expected_number_kmers_in_short_read_sketch) * fraction_kmers_required_for_cluster;
     BOOST_LOG_TRIVIAL(debug) << "Length based cluster threshold min("
-                             << prgs[(*mh_previous)->prg_id]->kmer_prg.min_path_length() << ", "
+                             << prgs[(*mh_previous)->prg_id]->min_path_length() << ", "
                              << expected_number_kmers_in_short_read_sketch << ") * "
                              << fraction_kmers_required_for_cluster << " = " << length_based_threshold;
     if (current_cluster.size() >
@@ -351,6 +582,26 @@ add_clusters_to_pangraph(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp>
     }
 }
 
+// Defines the clusters of the hits of whole reads and keeps those which are not noise, clearing the hits. Clusters do
+// not span reads, so the reads may be clustered all together or in any batches.
+void cluster_read_hits(std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &clusters_of_hits,
+                       const std::vector<std::shared_ptr<LocalPRG>> &prgs,
+                       std::shared_ptr<MinimizerHits> minimizer_hits,
+                       const int max_diff,
+                       const float &fraction_kmers_required_for_cluster,
+                       const uint32_t min_cluster_size,
+                       const uint32_t expected_number_kmers_in_short_read_sketch) {
+    minimizer_hits->sort();
+    if (minimizer_hits->hits.empty()) { return; }
+
+    define_clusters(clusters_of_hits, prgs, minimizer_hits, max_diff, fraction_kmers_required_for_cluster,
+                    min_cluster_size, expected_number_kmers_in_short_read_sketch);
+
+    minimizer_hits->clear();
+
+    filter_clusters(clusters_of_hits);
+}
+
 void infer_localPRG_order_for_reads(const std::vector<std::shared_ptr<LocalPRG>> &prgs,
                                     std::shared_ptr<MinimizerHits> minimizer_hits,
                                     std::shared_ptr<pangenome::Graph> pangraph,
@@ -362,20 +613,61 @@ void infer_localPRG_order_for_reads(const std::vector<std::shared_ptr<LocalPRG>>
     // by defining clusters of hits, keeping those which are not noise and
     // then adding the inferred gene ordering
 
-    minimizer_hits->sort();
-    if (minimizer_hits->hits.empty()) { return; }
-
     std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> clusters_of_hits;
-    define_clusters(clusters_of_hits, prgs, minimizer_hits, max_diff, fraction_kmers_required_for_cluster,
-                    min_cluster_size, expected_number_kmers_in_short_read_sketch);
-
-    minimizer_hits->clear();
-
-    filter_clusters(clusters_of_hits);
+    cluster_read_hits(clusters_of_hits, prgs, minimizer_hits, max_diff, fraction_kmers_required_for_cluster,
+                      min_cluster_size, expected_number_kmers_in_short_read_sketch);
     //filter_clusters2(clusters_of_hits, genome_size);
     add_clusters_to_pangraph(clusters_of_hits, pangraph, prgs);
 }
 
+namespace {
+    struct ReadSummary {
+        uint32_t length;
+        uint32_t sketch_size;
+        bool has_ambiguous_bases;
+    };
+
+    struct ReadJobResult {
+        std::vector<ReadSummary> reads;
+        // in order of the reads, of each read or, if sort_merge_hits, of all the reads together
+        std::vector<std::set<std::set<MinimizerHitPtr, pComp>, clusterComp>> clusters_of_hits;
+        uint32_t num_masked_minimizers;
+    };
+
+    // Consecutive reads for a worker thread of pangraph_from_read_file to sketch and cluster the hits of
+    struct ReadJob {
+        std::vector<FastaqRecordView> reads;
+        std::deque<std::string> copies; //of reads which are not views into a mapped file, so that the views last
+        uint32_t expected_number_kmers_in_short_read_sketch;
+        std::promise<ReadJobResult> result;
+    };
+
+    // The worker threads of pangraph_from_read_file, which are joined however it returns, as when reading the file
+    // fails, since a thread still joinable when destroyed ends the program
+    struct ReadJobWorkers {
+        BoundedQueue<std::unique_ptr<ReadJob>> &jobs;
+        std::vector<std::thread> threads;
+
+        explicit ReadJobWorkers(BoundedQueue<std::unique_ptr<ReadJob>> &jobs) : jobs(jobs) {}
+
+        ~ReadJobWorkers() {
+            // jobs left when returning early are not worth finishing
+            jobs.close();
+            std::unique_ptr<ReadJob> unwanted_job;
+            while (jobs.pop(unwanted_job));
+            join();
+        }
+
+        // once the jobs are closed, waits for the workers to finish those queued
+        void join() {
+            jobs.close();
+            for (auto &thread : threads)
+                if (thread.joinable())
+                    thread.join();
+        }
+    };
+}
+
 uint32_t pangraph_from_read_file(const std::string &filepath,
                                  std::shared_ptr<MinimizerHits> minimizer_hits,
                                  std::shared_ptr<pangenome::Graph> pangraph,
@@ -389,51 +681,267 @@ uint32_t pangraph_from_read_file(const std::string &filepath,
                                  const uint32_t genome_size,
                                  const bool illumina,
                                  const bool clean,
-                                 const uint32_t max_covg) {
+                                 const uint32_t max_covg,
+                                 const bool sort_merge_hits,
+                                 const std::string &read_index_filepath,
+                                 const uint32_t threads) {
     uint64_t covg = 0;
     float fraction_kmers_required_for_cluster = 0.5 / exp(e_rate * k);
     uint32_t expected_number_kmers_in_short_read_sketch = std::numeric_limits<uint32_t>::max();
     auto sequence = std::make_shared<Seq>(Seq(0, "null", "", w, k));
     uint32_t id = 0;
-
-    FastaqHandler fh(filepath);
-    while (!fh.eof()) {
-        fh.get_next();
-        sequence->initialize(id, fh.name, fh.read, w, k);
+    uint64_t num_masked_minimizers = 0;
+    uint32_t num_reads_with_ambiguous_bases = 0; //which are sketched between their non ACGT bases
+    uint64_t num_minimizers_between_ambiguous_bases = 0;
+    ReadBatch batch; //if sort_merge_hits, reads whose hits are yet to be found
+
+    const auto add_batch_hits = [&index](ReadBatch &read_batch, std::shared_ptr<MinimizerHits> &hits) {
+        const auto num_hits = hits->uhits.size();
+        const auto num_masked = add_read_batch_hits(read_batch, hits, index);
+        read_batch.found_hits(hits->uhits.size() - num_hits);
+        read_batch.clear();
+        return num_masked;
+    };
+
+    // false once no more reads are wanted
+    const auto add_read = [&](const boost::string_view &name, const boost::string_view &seq) -> bool {
+        sequence->initialize(id, name, seq, w, k);
         if (!sequence->sketch.empty()) {
             covg += sequence->seq.length();
             if (covg / genome_size > max_covg) {
                 BOOST_LOG_TRIVIAL(warning) << "Stop reading readfile as have reached max coverage";
-                break;
+                return false;
             }
         } else {
             id++;
-            continue;
+            return true;
         }
         if (illumina and expected_number_kmers_in_short_read_sketch == std::numeric_limits<uint32_t>::max()) {
             assert(w != 0);
             expected_number_kmers_in_short_read_sketch = sequence->seq.length() * 2 / w;
         }
+        if (sequence->num_ambiguous_bases > 0) {
+            num_reads_with_ambiguous_bases += 1;
+            num_minimizers_between_ambiguous_bases += sequence->sketch.size();
+        }
         //cout << now() << "Add read hits" << endl;
-        add_read_hits(sequence, minimizer_hits, index);
+        // the hits of a read, or of a batch of reads, are clustered as soon as they are found, so minimizer_hits only
+        // ever holds those
+        if (sort_merge_hits) {
+            batch.add(*sequence);
+            if (batch.is_full()) {
+                num_masked_minimizers += add_batch_hits(batch, minimizer_hits);
+                infer_localPRG_order_for_reads(prgs, minimizer_hits, pangraph, max_diff, genome_size,
+                                               fraction_kmers_required_for_cluster, min_cluster_size,
+                                               expected_number_kmers_in_short_read_sketch);
+            }
+        } else {
+            num_masked_minimizers += add_read_hits(sequence, minimizer_hits, index);
+            infer_localPRG_order_for_reads(prgs, minimizer_hits, pangraph, max_diff, genome_size,
+                                           fraction_kmers_required_for_cluster, min_cluster_size,
+                                           expected_number_kmers_in_short_read_sketch);
+        }
         id++;
         if (id > 10000000) {
             BOOST_LOG_TRIVIAL(debug) << "Stop reading readfile as have reached 10,000,000 reads";
-            break;
+            return false;
         }
+        return true;
+    };
+
+    // With several threads, workers sketch reads and find and cluster their hits in jobs of consecutive reads, and the
+    // clusters are added to the pangraph here in the order of the reads, so the pangraph is the same however many
+    // threads there are. Reading stops at the same read as with one thread.
+    const size_t max_job_bases = 1 << 21;
+    BoundedQueue<std::unique_ptr<ReadJob>> jobs(threads);
+    std::deque<std::future<ReadJobResult>> results; //of the jobs not yet added to the pangraph, in order
+    std::unique_ptr<ReadJob> job; //filling up to be queued
+    size_t job_bases = 0;
+    uint32_t num_queued = 0;
+    bool stopped = false;
+    ReadJobWorkers workers(jobs);
+
+    const auto run_jobs = [&]() {
+        auto read = std::make_shared<Seq>(Seq(0, "null", "", w, k));
+        auto read_hits = std::make_shared<MinimizerHits>();
+        ReadBatch read_batch;
+        std::unique_ptr<ReadJob> worker_job;
+        while (jobs.pop(worker_job)) {
+            try {
+                ReadJobResult result;
+                result.num_masked_minimizers = 0;
+                const auto cluster_hits = [&]() {
+                    std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> clusters_of_hits;
+                    cluster_read_hits(clusters_of_hits, prgs, read_hits, max_diff, fraction_kmers_required_for_cluster,
+                                      min_cluster_size, worker_job->expected_number_kmers_in_short_read_sketch);
+                    if (!clusters_of_hits.empty())
+                        result.clusters_of_hits.push_back(std::move(clusters_of_hits));
+                };
+                for (const auto &record : worker_job->reads) {
+                    read->initialize(record.id, record.name, record.seq, w, k);
+                    result.reads.push_back({(uint32_t) read->seq.length(), (uint32_t) read->sketch.size(),
+                                            read->num_ambiguous_bases > 0});
+                    if (read->sketch.empty()) {
+                        continue;
+                    } else if (sort_merge_hits) {
+                        read_batch.add(*read);
+                        if (read_batch.is_full()) {
+                            result.num_masked_minimizers += add_batch_hits(read_batch, read_hits);
+                            cluster_hits();
+                        }
+                    } else {
+                        result.num_masked_minimizers += add_read_hits(read, read_hits, index);
+                        cluster_hits();
+                    }
+                }
+                if (!read_batch.minimizers.empty()) {
+                    result.num_masked_minimizers += add_batch_hits(read_batch, read_hits);
+                    cluster_hits();
+                }
+                worker_job->result.set_value(std::move(result));
+            } catch (...) {
+                // rethrown by the thread adding the result
+                worker_job->result.set_exception(std::current_exception());
+            }
+        }
+    };
+
+    // counts the reads of a job as add_read does and adds the clusters of those wanted, false once no more reads are
+    const auto add_job_result = [&](ReadJobResult result) -> bool {
+        for (const auto &read : result.reads) {
+            if (read.sketch_size > 0) {
+                covg += read.length;
+                if (covg / genome_size > max_covg) {
+                    BOOST_LOG_TRIVIAL(warning) << "Stop reading readfile as have reached max coverage";
+                    stopped = true;
+                    break;
+                }
+            } else {
+                id++;
+                continue;
+            }
+            if (read.has_ambiguous_bases) {
+                num_reads_with_ambiguous_bases += 1;
+                num_minimizers_between_ambiguous_bases += read.sketch_size;
+            }
+            id++;
+            if (id > 10000000) {
+                BOOST_LOG_TRIVIAL(debug) << "Stop reading readfile as have reached 10,000,000 reads";
+                stopped = true;
+                break;
+            }
+        }
+        num_masked_minimizers += result.num_masked_minimizers;
+        for (auto &clusters_of_hits : result.clusters_of_hits) {
+            for (auto it = clusters_of_hits.begin(); it != clusters_of_hits.end();) {
+                if ((*it->begin())->read_id >= id)
+                    it = clusters_of_hits.erase(it);
+                else
+                    ++it;
+            }
+            add_clusters_to_pangraph(clusters_of_hits, pangraph, prgs);
+        }
+        return !stopped;
+    };
+
+    const auto queue_job = [&]() -> bool {
+        while (results.size() >= 2 * threads) {
+            if (!add_job_result(results.front().get()))
+                return false;
+            results.pop_front();
+        }
+        job->expected_number_kmers_in_short_read_sketch = expected_number_kmers_in_short_read_sketch;
+        results.push_back(job->result.get_future());
+        jobs.push(std::move(job));
+        job_bases = 0;
+        return true;
+    };
+
+    // false once no more reads are wanted
+    const auto queue_read = [&](const boost::string_view &name, const boost::string_view &seq,
+                                const bool lasts) -> bool {
+        // clustering depends on the first read with a sketch, so that is found before any jobs are queued
+        if (illumina and expected_number_kmers_in_short_read_sketch == std::numeric_limits<uint32_t>::max()) {
+            sequence->initialize(num_queued, name, seq, w, k);
+            if (!sequence->sketch.empty()) {
+                assert(w != 0);
+                expected_number_kmers_in_short_read_sketch = sequence->seq.length() * 2 / w;
+            }
+        }
+        if (job == nullptr)
+            job.reset(new ReadJob());
+        if (lasts) {
+            job->reads.push_back({num_queued, name, seq});
+        } else {
+            job->copies.emplace_back(name.data(), name.size());
+            job->copies.emplace_back(seq.data(), seq.size());
+            job->reads.push_back({num_queued, *(job->copies.end() - 2), job->copies.back()});
+        }
+        num_queued++;
+        job_bases += seq.size();
+        return job_bases < max_job_bases or queue_job();
+    };
+
+    const auto finish_jobs = [&]() {
+        if (!stopped and job != nullptr)
+            queue_job();
+        jobs.close();
+        std::unique_ptr<ReadJob> unwanted_job;
+        while (stopped and jobs.pop(unwanted_job));
+        while (!stopped and !results.empty()) {
+            add_job_result(results.front().get());
+            results.pop_front();
+        }
+        workers.join();
+    };
 
-        if (minimizer_hits->uhits.size() > 90000) {
-            BOOST_LOG_TRIVIAL(debug) << "Infer gene orders and add to pangenome::Graph";
-            pangraph->reserve_num_reads(id);
-            infer_localPRG_order_for_reads(prgs, minimizer_hits, pangraph, max_diff, genome_size,
-                                           fraction_kmers_required_for_cluster, min_cluster_size,
-                                           expected_number_kmers_in_short_read_sketch);
+    if (threads > 1) {
+        for (uint32_t i = 0; i != threads; ++i)
+            workers.threads.emplace_back(run_jobs);
+    }
+
+    ReadIndexBuilder read_index; //saved to read_index_filepath if given, for finding reads again by id
+    // reads streamed through a pipe cannot be mapped into memory, nor found again by offset
+    const bool regular_file = boost::filesystem::is_regular_file(filepath);
+    const bool save_read_index = !read_index_filepath.empty() and regular_file;
+    if (!regular_file or (filepath.length() >= 2 and filepath.substr(filepath.length() - 2) == "gz")) {
+        FastaqReader reader(filepath, save_read_index ? &read_index : nullptr);
+        std::vector<FastaqRecord> records;
+        bool finished_reading = false;
+        while (!finished_reading and reader.next_batch(records)) {
+            for (const auto &record : records) {
+                if (!(threads > 1 ? queue_read(record.name, record.seq, false) : add_read(record.name, record.seq))) {
+                    finished_reading = true;
+                    break;
+                }
+            }
         }
+        finish_jobs();
+        reader.close();
+    } else {
+        // parsing is cheap next to sketching, so is done in this thread without copying the reads
+        MappedFastaqReader reader(filepath, save_read_index ? &read_index : nullptr);
+        FastaqRecordView record;
+        while (reader.next(record) and (threads > 1 ? queue_read(record.name, record.seq, reader.is_mapped(record.seq))
+                                                    : add_read(record.name, record.seq)));
+        finish_jobs();
     }
+    if (save_read_index)
+        read_index.save(filepath, read_index_filepath);
+    if (!batch.minimizers.empty())
+        num_masked_minimizers += add_batch_hits(batch, minimizer_hits);
     BOOST_LOG_TRIVIAL(debug) << "Found " << id << " reads";
-
+    if (num_reads_with_ambiguous_bases > 0)
+        BOOST_LOG_TRIVIAL(info) << "Sketched " << num_reads_with_ambiguous_bases
+                                << " reads with non ACGT bases between those bases, keeping "
+                                << num_minimizers_between_ambiguous_bases << " minimizers";
+    if (index->max_occurrences != std::numeric_limits<uint32_t>::max())
+        BOOST_LOG_TRIVIAL(info) << "Skipped " << num_masked_minimizers
+                                << " read minimizers which are masked as too frequent in the index";
+
+    // the reads of the pangraph are not reserved for, as the order they are iterated in when writing it out depends on
+    // when their table is rehashed, which should only depend on the reads added
     BOOST_LOG_TRIVIAL(debug) << "Infer gene orders and add to pangenome::Graph";
-    pangraph->reserve_num_reads(id);
     infer_localPRG_order_for_reads(prgs, minimizer_hits, pangraph, max_diff, genome_size, fraction_kmers_required_for_cluster,
                                    min_cluster_size, expected_number_kmers_in_short_read_sketch);
 
@@ -12,18 +12,34 @@
 
 int pandora_walk(int argc, char *argv[]) // the "pandora walk" comand
 {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: pandora walk <in_prg.fa> [<seq.fa> | --top | --bottom]\n");
+    // options may come before or between the arguments
+    std::vector<std::string> args;
+    uint32_t threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-t") || (arg == "--threads")) {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                threads = (unsigned) atoi(argv[++i]); // Increment 'i' so we don't get the argument as the next argv[i].
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "--threads option requires one argument." << std::endl;
+                return 1;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.size() != 2) {
+        fprintf(stderr, "Usage: pandora walk [-t <threads>] <in_prg.fa> [<seq.fa> | --top | --bottom]\n");
         return 1;
     }
 
     // load prgs
     std::vector<std::shared_ptr<LocalPRG>> prgs;
-    read_prg_file(prgs, argv[1]);
+    read_prg_file(prgs, args[0], 0, threads);
 
     std::vector<LocalNodePtr> npath;
 
-    if (strcmp(argv[2], "--top") == 0) {
+    if (args[1] == "--top") {
         for (const auto &prg_ptr : prgs) {
             npath = prg_ptr->prg.top_path();
             std::cout << prg_ptr->name << "\t";
@@ -33,7 +49,7 @@ int pandora_walk(int argc, char *argv[]) // the "pandora walk" comand
             std::cout << std::endl;
         }
         return 0;
-    } else if (strcmp(argv[2], "--bottom") == 0) {
+    } else if (args[1] == "--bottom") {
         for (const auto &prg_ptr: prgs) {
             npath = prg_ptr->prg.bottom_path();
             std::cout << prg_ptr->name << "\t";
@@ -47,7 +63,7 @@ int pandora_walk(int argc, char *argv[]) // the "pandora walk" comand
 
     // for each read in readfile,  infer node path along sequence
     std::string read_string;
-    FastaqHandler readfile(argv[2]);
+    FastaqHandler readfile(args[1]);
     while (not readfile.eof()) {
         readfile.get_next();
         //cout << "Try to find gene " << readfile.num_reads_parsed << " " << readfile.name << endl << readfile.read << endl;
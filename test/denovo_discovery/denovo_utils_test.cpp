@@ -471,11 +471,11 @@ TEST(FindIntervalInLocalPathTest, intervalSpanningPastEndOfPrgReturnsUpToEndOfPr
 
 
 TEST(FindHitsInsidePathTest, emptyPathReturnsEmpty) {
-    std::set<MinimizerHitPtr, pComp_path> hits;
+    std::vector<MinimizerHit> hits;
     prg::Path local_path;
 
     const auto actual { find_hits_inside_path(hits, local_path) };
-    const std::set<MinimizerHitPtr, pComp_path> expected;
+    const std::vector<MinimizerHit> expected;
 
     EXPECT_EQ(actual, expected);
 }
@@ -495,16 +495,15 @@ TEST(FindHitsInsidePathTest, hitNotOnPathReturnEmpty) {
     prg::Path prg_path;
     prg_path.initialize(intervals);
 
-    std::set<MinimizerHitPtr, pComp_path> read_hits;
-    MinimizerHitPtr minimizer_hit {
-            std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
+    std::vector<MinimizerHit> read_hits;
+    MinimizerHit minimizer_hit { read_id, read_interval, prg_id, prg_path, knode_id, is_forward };
+    read_hits.push_back(minimizer_hit);
     prg::Path local_path;
     for (const auto &node : local_max_likelihood_path) {
         local_path.add_end_interval(node->pos);
     }
-    std::set<MinimizerHitPtr, pComp_path> actual { find_hits_inside_path(read_hits, local_path) };
-    std::set<MinimizerHitPtr, pComp_path> expected;
+    std::vector<MinimizerHit> actual { find_hits_inside_path(read_hits, local_path) };
+    std::vector<MinimizerHit> expected;
 
     EXPECT_EQ(actual, expected);
 }
@@ -524,22 +523,21 @@ TEST(FindHitsInsidePathTest, hitsBranchingFromPathReturnEmpty) {
     prg::Path prg_path;
     prg_path.initialize(intervals);
 
-    std::set<MinimizerHitPtr, pComp_path> read_hits;
-    MinimizerHitPtr minimizer_hit {
-            std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
+    std::vector<MinimizerHit> read_hits;
+    MinimizerHit minimizer_hit { read_id, read_interval, prg_id, prg_path, knode_id, is_forward };
+    read_hits.push_back(minimizer_hit);
 
     intervals = { Interval(29, 30), Interval(31, 33) };
     prg_path.initialize(intervals);
-    minimizer_hit = { std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
+    minimizer_hit = MinimizerHit(read_id, read_interval, prg_id, prg_path, knode_id, is_forward);
+    read_hits.push_back(minimizer_hit);
 
     prg::Path local_path;
     for (const auto &node : local_max_likelihood_path) {
         local_path.add_end_interval(node->pos);
     }
-    std::set<MinimizerHitPtr, pComp_path> actual { find_hits_inside_path(read_hits, local_path) };
-    std::set<MinimizerHitPtr, pComp_path> expected;
+    std::vector<MinimizerHit> actual { find_hits_inside_path(read_hits, local_path) };
+    std::vector<MinimizerHit> expected;
 
     EXPECT_EQ(actual, expected);
 }
@@ -559,27 +557,26 @@ TEST(FindHitsInsidePathTest, hitsOverlappingEdgesOfPathReturnEmpty) {
     prg::Path prg_path;
     prg_path.initialize(intervals);
 
-    std::set<MinimizerHitPtr, pComp_path> read_hits;
-    MinimizerHitPtr minimizer_hit {
-            std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
+    std::vector<MinimizerHit> read_hits;
+    MinimizerHit minimizer_hit { read_id, read_interval, prg_id, prg_path, knode_id, is_forward };
+    read_hits.push_back(minimizer_hit);
 
     intervals = { Interval(29, 30), Interval(33, 33), Interval(40, 42) };
     prg_path.initialize(intervals);
-    minimizer_hit = { std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
+    minimizer_hit = MinimizerHit(read_id, read_interval, prg_id, prg_path, knode_id, is_forward);
+    read_hits.push_back(minimizer_hit);
 
     intervals = { Interval(28, 30), Interval(33, 33), Interval(40, 41) };
     prg_path.initialize(intervals);
-    minimizer_hit = { std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
+    minimizer_hit = MinimizerHit(read_id, read_interval, prg_id, prg_path, knode_id, is_forward);
+    read_hits.push_back(minimizer_hit);
 
     prg::Path local_path;
     for (const auto &node : local_max_likelihood_path) {
         local_path.add_end_interval(node->pos);
     }
-    std::set<MinimizerHitPtr, pComp_path> actual { find_hits_inside_path(read_hits, local_path) };
-    std::set<MinimizerHitPtr, pComp_path> expected;
+    std::vector<MinimizerHit> actual { find_hits_inside_path(read_hits, local_path) };
+    std::vector<MinimizerHit> expected;
 
     EXPECT_EQ(actual, expected);
 }
@@ -595,41 +592,40 @@ TEST(FindHitsInsidePathTest, hitsOnPathReturnCorrectHits) {
     const uint32_t knode_id { 0 };
     const Interval read_interval { 1, 4 };
     const bool is_forward { true };
-    std::set<MinimizerHitPtr, pComp_path> expected;
+    std::vector<MinimizerHit> expected;
 
     std::deque<Interval> intervals { Interval(4, 5), Interval(8, 9), Interval(16, 17) };
     prg::Path prg_path;
     prg_path.initialize(intervals);
 
-    std::set<MinimizerHitPtr, pComp_path> read_hits;
-    MinimizerHitPtr minimizer_hit {
-            std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
-    expected.insert(minimizer_hit);
+    std::vector<MinimizerHit> read_hits;
+    MinimizerHit minimizer_hit { read_id, read_interval, prg_id, prg_path, knode_id, is_forward };
+    read_hits.push_back(minimizer_hit);
+    expected.push_back(minimizer_hit);
 
     intervals = { Interval(8, 9), Interval(16, 17), Interval(27, 28) };
     prg_path.initialize(intervals);
-    minimizer_hit = { std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
-    expected.insert(minimizer_hit);
+    minimizer_hit = MinimizerHit(read_id, read_interval, prg_id, prg_path, knode_id, is_forward);
+    read_hits.push_back(minimizer_hit);
+    expected.push_back(minimizer_hit);
 
     intervals = { Interval(16, 17), Interval(27, 29) };
     prg_path.initialize(intervals);
-    minimizer_hit = { std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
-    expected.insert(minimizer_hit);
+    minimizer_hit = MinimizerHit(read_id, read_interval, prg_id, prg_path, knode_id, is_forward);
+    read_hits.push_back(minimizer_hit);
+    expected.push_back(minimizer_hit);
 
     intervals = { Interval(27, 30) };
     prg_path.initialize(intervals);
-    minimizer_hit = { std::make_shared<MinimizerHit>(read_id, read_interval, prg_id, prg_path, knode_id, is_forward) };
-    read_hits.insert(minimizer_hit);
-    expected.insert(minimizer_hit);
+    minimizer_hit = MinimizerHit(read_id, read_interval, prg_id, prg_path, knode_id, is_forward);
+    read_hits.push_back(minimizer_hit);
+    expected.push_back(minimizer_hit);
 
     prg::Path local_path;
     for (const auto &node : local_max_likelihood_path) {
         local_path.add_end_interval(node->pos);
     }
-    std::set<MinimizerHitPtr, pComp_path> actual { find_hits_inside_path(read_hits, local_path) };
+    std::vector<MinimizerHit> actual { find_hits_inside_path(read_hits, local_path) };
 
     EXPECT_EQ(actual, expected);
 }
@@ -0,0 +1,127 @@
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include "gtest/gtest.h"
+#include "fastaq_handler.h"
+#include "fastaq_reader.h"
+
+
+using namespace std;
+
+static vector<FastaqRecord> read_all(const string &filepath) {
+    vector<FastaqRecord> records, batch;
+    FastaqReader reader(filepath);
+    while (reader.next_batch(batch)) {
+        EXPECT_FALSE(batch.empty());
+        records.insert(records.end(), batch.begin(), batch.end());
+    }
+    return records;
+}
+
+TEST(FastaqReaderTest, same_records_as_fastaq_handler) {
+    for (const auto &filepath : {"../../test/test_cases/reads.fa", "../../test/test_cases/reads.fq",
+                                 "../../test/test_cases/reads.fa.gz", "../../test/test_cases/reads.fq.gz"}) {
+        const auto records = read_all(filepath);
+        FastaqHandler fh(filepath);
+        uint32_t i = 0;
+        while (!fh.eof()) {
+            fh.get_next();
+            ASSERT_LT(i, records.size());
+            EXPECT_EQ(i, records[i].id);
+            EXPECT_EQ(fh.name, records[i].name);
+            EXPECT_EQ(fh.read, records[i].seq);
+            ++i;
+        }
+        EXPECT_EQ(i, records.size());
+    }
+}
+
+TEST(FastaqReaderTest, awkward_records) {
+    ofstream handle("fastaq_reader_test.fq");
+    handle << "@read0 with a comment\r\nACGT\r\n+\r\n@@@@\r\n"
+           << "@read1\nACGTACGT\n+read1\n@@@@\nIIII\n"
+           << "@empty\n\n+\n\n"
+           << "\n@read3\nAC\nGT\n+\n>>>>\n"
+           << "@read4\nTTTT\n+\nIIII";
+    handle.close();
+
+    const auto records = read_all("fastaq_reader_test.fq");
+    const vector<pair<string, string>> expected = {{"read0 with a comment", "ACGT"}, {"read1", "ACGTACGT"},
+                                                   {"empty", ""}, {"read3", "ACGT"}, {"read4", "TTTT"}};
+    ASSERT_EQ(expected.size(), records.size());
+    for (uint32_t i = 0; i != records.size(); ++i) {
+        EXPECT_EQ(i, records[i].id);
+        EXPECT_EQ(expected[i].first, records[i].name);
+        EXPECT_EQ(expected[i].second, records[i].seq);
+    }
+}
+
+TEST(FastaqReaderTest, many_chunks_and_batches) {
+    // records spanning chunks, as a plain and a gzipped file
+    vector<string> seqs;
+    string text;
+    for (uint32_t i = 0; i != 3000; ++i) {
+        seqs.emplace_back(1000 + i % 777, "ACGT"[i % 4]);
+        text += ">read" + to_string(i) + "\n" + seqs.back().substr(0, 600) + "\n" + seqs.back().substr(600) + "\n";
+    }
+    ASSERT_GT(text.size(), 2 * FastaqReader::chunk_size);
+    ofstream("fastaq_reader_test.fa") << text;
+    {
+        ofstream gzipped_file("fastaq_reader_test.fa.gz", ios::binary);
+        boost::iostreams::filtering_ostream gzipped;
+        gzipped.push(boost::iostreams::gzip_compressor());
+        gzipped.push(gzipped_file);
+        gzipped << text;
+    }
+
+    for (const auto &filepath : {"fastaq_reader_test.fa", "fastaq_reader_test.fa.gz"}) {
+        const auto records = read_all(filepath);
+        ASSERT_EQ(seqs.size(), records.size());
+        for (uint32_t i = 0; i != records.size(); ++i) {
+            EXPECT_EQ(i, records[i].id);
+            EXPECT_EQ("read" + to_string(i), records[i].name);
+            EXPECT_EQ(seqs[i], records[i].seq);
+        }
+    }
+
+    // stopping early does not wait for the rest of the file
+    FastaqReader reader("fastaq_reader_test.fa.gz");
+    vector<FastaqRecord> batch;
+    EXPECT_TRUE(reader.next_batch(batch));
+    EXPECT_EQ((uint32_t) 0, batch[0].id);
+}
+
+TEST(FastaqReaderTest, record_longer_than_chunk) {
+    // single line sequences over several chunks, between short records
+    string long_seq;
+    for (uint32_t i = 0; i != 3 * FastaqReader::chunk_size + 123; ++i)
+        long_seq += "ACGT"[i % 4];
+    const string text = ">short0\nACGT\n>long\n" + long_seq + "\n>short1\nTTTT\n";
+    ofstream("fastaq_reader_test_long.fa") << text;
+    {
+        ofstream gzipped_file("fastaq_reader_test_long.fa.gz", ios::binary);
+        boost::iostreams::filtering_ostream gzipped;
+        gzipped.push(boost::iostreams::gzip_compressor());
+        gzipped.push(gzipped_file);
+        gzipped << text;
+    }
+
+    for (const auto &filepath : {"fastaq_reader_test_long.fa", "fastaq_reader_test_long.fa.gz"}) {
+        const auto records = read_all(filepath);
+        ASSERT_EQ((size_t) 3, records.size());
+        EXPECT_EQ("ACGT", records[0].seq);
+        EXPECT_EQ("long", records[1].name);
+        EXPECT_EQ(long_seq, records[1].seq);
+        EXPECT_EQ("short1", records[2].name);
+        EXPECT_EQ("TTTT", records[2].seq);
+    }
+}
+
+TEST(FastaqReaderTest, corrupt_gzip_throws) {
+    ofstream("fastaq_reader_test_corrupt.fa.gz") << ">read0\nACGT\n";
+    FastaqReader reader("fastaq_reader_test_corrupt.fa.gz");
+    vector<FastaqRecord> batch;
+    EXPECT_ANY_THROW(while (reader.next_batch(batch)) {});
+}
@@ -5,10 +5,17 @@
 #include "interval.h"
 #include "inthash.h"
 #include "utils.h"
+#include "kmergraph_store.h"
+#include "localPRG.h"
 #include <vector>
 #include <stdint.h>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <algorithm>
+#include <limits>
+#include <random>
+#include <thread>
 
 
 using namespace std;
@@ -87,12 +94,12 @@ TEST(IndexTest, load) {
     idx1.add_record(min(kh1.first, kh1.second), 4, p, 0, 0);
 
     idx2.load("indextext", 1, 5);
-    EXPECT_EQ(idx1.minhash.size(), idx2.minhash.size());
-    EXPECT_EQ(idx1.minhash[min(kh1.first, kh1.second)]->size(), idx2.minhash[min(kh1.first, kh1.second)]->size());
-    EXPECT_EQ(idx1.minhash[min(kh2.first, kh2.second)]->size(), idx2.minhash[min(kh2.first, kh2.second)]->size());
-    EXPECT_EQ(idx1.minhash[min(kh1.first, kh1.second)]->at(0), idx2.minhash[min(kh1.first, kh1.second)]->at(0));
-    EXPECT_EQ(idx1.minhash[min(kh1.first, kh1.second)]->at(1), idx2.minhash[min(kh1.first, kh1.second)]->at(1));
-    EXPECT_EQ(idx1.minhash[min(kh2.first, kh2.second)]->at(0), idx2.minhash[min(kh2.first, kh2.second)]->at(0));
+    EXPECT_EQ(idx1.num_keys(), idx2.num_keys());
+    EXPECT_EQ(idx1.find(min(kh1.first, kh1.second)).size(), idx2.find(min(kh1.first, kh1.second)).size());
+    EXPECT_EQ(idx1.find(min(kh2.first, kh2.second)).size(), idx2.find(min(kh2.first, kh2.second)).size());
+    EXPECT_EQ(idx1.find(min(kh1.first, kh1.second)).first[0], idx2.find(min(kh1.first, kh1.second)).first[0]);
+    EXPECT_EQ(idx1.find(min(kh1.first, kh1.second)).first[1], idx2.find(min(kh1.first, kh1.second)).first[1]);
+    EXPECT_EQ(idx1.find(min(kh2.first, kh2.second)).first[0], idx2.find(min(kh2.first, kh2.second)).first[0]);
 }
 
 TEST(IndexTest, equals) {
@@ -137,38 +144,275 @@ TEST(IndexTest, equals_fails) {
     EXPECT_NE(idx2, idx1);
 }
 
-TEST(IndexTest, merging_indexes) {
-    uint32_t w=2,k=3;
-    std::vector<std::shared_ptr<LocalPRG>> prgs;
-    auto index = std::make_shared<Index>();
-    auto outdir = "../../test/test_cases/kgs/";
-
-    read_prg_file(prgs, "../../test/test_cases/prg1.fa", 1);
-    index_prgs(prgs, index, w, k, outdir);
-    index->save("../../test/test_cases/prg1.fa.idx");
-
-    prgs.clear();
-    index->clear();
-    read_prg_file(prgs, "../../test/test_cases/prg2.fa", 2);
-    index_prgs(prgs, index, w, k, outdir);
-    index->save("../../test/test_cases/prg2.fa.idx");
-
-
-    prgs.clear();
-    index->clear();
-    read_prg_file(prgs, "../../test/test_cases/prg3.fa", 3);
-    index_prgs(prgs, index, w, k, outdir);
-    index->save("../../test/test_cases/prg3.fa.idx");
-
-    //merge
-    auto index_merged = std::make_shared<Index>();
-    index_merged->load("../../test/test_cases/prg1.fa.idx");
-    index_merged->load("../../test/test_cases/prg2.fa.idx");
-    index_merged->load("../../test/test_cases/prg3.fa.idx");
-
-    // now an index from all 4 in
-    prgs.clear();
-    auto index_all = std::make_shared<Index>();
-    read_prg_file(prgs, "../../test/test_cases/prg0123.fa");
-    index_prgs(prgs, index_all, w, k, outdir);
+TEST(IndexTest, save_text_and_load) {
+    Index idx1, idx2;
+    KmerHash hash;
+    deque<Interval> d = {Interval(3, 5), Interval(9, 12)};
+    prg::Path p;
+    p.initialize(d);
+    pair<uint64_t, uint64_t> kh1 = hash.kmerhash("ACGTA", 5);
+    idx1.add_record(min(kh1.first, kh1.second), 1, p, 0, 0);
+    pair<uint64_t, uint64_t> kh2 = hash.kmerhash("ACTGA", 5);
+    idx1.add_record(min(kh2.first, kh2.second), 2, p, 0, 0);
+    idx1.add_record(min(kh1.first, kh1.second), 4, p, 0, 0);
+
+    idx1.save_text("indextext.text.idx");
+    idx2.load("indextext.text.idx");
+    EXPECT_EQ(idx1, idx2);
+    EXPECT_EQ((uint32_t) 5, idx2.num_prgs);
+}
+
+TEST(IndexTest, save_and_load_binary_keeps_records) {
+    Index idx1, idx2;
+    KmerHash hash;
+    deque<Interval> d = {Interval(3, 5), Interval(9, 12)};
+    prg::Path p, q, r;
+    p.initialize(d);
+    q.initialize(Interval(7, 12));
+    r.initialize(Interval(0, 0));
+    pair<uint64_t, uint64_t> kh1 = hash.kmerhash("ACGTA", 5);
+    idx1.add_record(min(kh1.first, kh1.second), 4, p, 3, 1);
+    idx1.add_record(min(kh1.first, kh1.second), 1, q, 7, 0);
+    idx1.add_record(min(kh1.first, kh1.second), 2, r, 0, 1);
+    pair<uint64_t, uint64_t> kh2 = hash.kmerhash("ACTGA", 5);
+    idx1.add_record(min(kh2.first, kh2.second), 2, q, 5, 0);
+
+    idx1.save("indexbinary.idx");
+    idx2.load("indexbinary.idx");
+    EXPECT_EQ(idx1, idx2);
+    auto records = idx2.find(min(kh1.first, kh1.second));
+    ASSERT_EQ((uint)3, records.size());
+    EXPECT_EQ((uint)4, records.first[0].prg_id);
+    EXPECT_EQ(p, records.first[0].path());
+    EXPECT_EQ((uint)3, records.first[0].knode_id);
+    EXPECT_TRUE(records.first[0].strand);
+    EXPECT_EQ((uint)1, records.first[1].prg_id);
+    EXPECT_EQ(q, records.first[1].path());
+    EXPECT_EQ((uint)7, records.first[1].knode_id);
+    EXPECT_FALSE(records.first[1].strand);
+    EXPECT_EQ((uint)2, records.first[2].prg_id);
+    EXPECT_EQ(r, records.first[2].path());
+
+    // loading again merges into the records already present
+    idx2.load("indexbinary.idx");
+    EXPECT_EQ((uint)2, idx2.num_keys());
+    EXPECT_EQ((uint)6, idx2.find(min(kh1.first, kh1.second)).size());
+}
+
+TEST(IndexTest, save_and_load_empty_binary) {
+    Index idx1, idx2;
+    idx1.save("indexempty.idx");
+    idx2.load("indexempty.idx");
+    EXPECT_EQ((uint)0, idx2.num_keys());
+}
+
+TEST(IndexTest, load_binary_finds_records_from_several_threads) {
+    Index idx1, idx2;
+    prg::Path p;
+    std::vector<uint64_t> keys;
+    std::mt19937_64 generator(1);
+    for (uint32_t i = 0; i != 20000; ++i) {
+        p.initialize(Interval(i % 500, i % 500 + 15));
+        keys.push_back(generator() % 5000);
+        idx1.add_record(keys.back(), i % 100, p, i, i % 2);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    idx1.save("indexthreads.idx");
+    idx2.load("indexthreads.idx");
+    EXPECT_EQ(idx1.num_keys(), idx2.num_keys());
+    EXPECT_EQ(idx1.num_records(), idx2.num_records());
+
+    // records are made the first time their key is found, here by all threads at once
+    std::vector<std::vector<MiniRecordSpan>> spans(4);
+    std::vector<std::thread> threads;
+    for (auto &thread_spans : spans)
+        threads.emplace_back([&idx2, &keys, &thread_spans]() { idx2.find(keys, thread_spans); });
+    for (auto &thread : threads)
+        thread.join();
+    for (size_t i = 0; i != keys.size(); ++i) {
+        const auto expected = idx1.find(keys[i]);
+        for (const auto &thread_spans : spans) {
+            EXPECT_EQ(spans[0][i].first, thread_spans[i].first);
+            ASSERT_EQ(expected.size(), thread_spans[i].size());
+            EXPECT_TRUE(std::equal(expected.begin(), expected.end(), thread_spans[i].begin()));
+        }
+    }
+    EXPECT_EQ(idx1, idx2);
+}
+
+TEST(IndexTest, save_loaded_binary_to_same_file) {
+    Index idx1, idx2, idx3;
+    KmerHash hash;
+    prg::Path p;
+    p.initialize(Interval(3, 8));
+    pair<uint64_t, uint64_t> kh = hash.kmerhash("ACGTA", 5);
+    idx1.add_record(min(kh.first, kh.second), 4, p, 3, 1);
+    idx1.save("indexresave.idx");
+
+    idx2.load("indexresave.idx");
+    idx2.save("indexresave.idx");
+    idx3.load("indexresave.idx");
+    EXPECT_EQ(idx1, idx2);
+    EXPECT_EQ(idx1, idx3);
+}
+
+TEST(IndexTest, freeze) {
+    Index idx;
+    KmerHash hash;
+    deque<Interval> d = {Interval(3, 5), Interval(9, 12)};
+    prg::Path p;
+    p.initialize(d);
+    pair<uint64_t, uint64_t> kh1 = hash.kmerhash("ACGTA", 5);
+    idx.add_record(min(kh1.first, kh1.second), 1, p, 0, 0);
+    idx.add_record(min(kh1.first, kh1.second), 4, p, 0, 0);
+    pair<uint64_t, uint64_t> kh2 = hash.kmerhash("ACTGA", 5);
+    idx.add_record(min(kh2.first, kh2.second), 2, p, 0, 0);
+    EXPECT_FALSE(idx.is_frozen());
+    EXPECT_EQ((uint)2, idx.find(min(kh1.first, kh1.second)).size());
+
+    idx.freeze();
+    EXPECT_TRUE(idx.is_frozen());
+    EXPECT_EQ((uint)0, idx.minhash.size());
+    EXPECT_EQ((uint)2, idx.num_keys());
+    EXPECT_EQ((uint)3, idx.num_records());
+    auto records = idx.find(min(kh1.first, kh1.second));
+    ASSERT_EQ((uint)2, records.size());
+    EXPECT_EQ((uint)1, records.first[0].prg_id);
+    EXPECT_EQ((uint)4, records.first[1].prg_id);
+    records = idx.find(min(kh2.first, kh2.second));
+    ASSERT_EQ((uint)1, records.size());
+    EXPECT_EQ((uint)2, records.first[0].prg_id);
+    pair<uint64_t, uint64_t> kh3 = hash.kmerhash("TTTTT", 5);
+    EXPECT_TRUE(idx.find(min(kh3.first, kh3.second)).empty());
+
+    // adding to a frozen index keeps the records already there
+    idx.add_record(min(kh1.first, kh1.second), 4, p, 0, 0);
+    idx.add_record(min(kh3.first, kh3.second), 5, p, 0, 0);
+    EXPECT_FALSE(idx.is_frozen());
+    idx.freeze();
+    EXPECT_EQ((uint)3, idx.num_keys());
+    EXPECT_EQ((uint)2, idx.find(min(kh1.first, kh1.second)).size());
+    EXPECT_EQ((uint)1, idx.find(min(kh3.first, kh3.second)).size());
+}
+
+TEST(IndexTest, mask_frequent_minimizers) {
+    Index idx;
+    prg::Path p;
+    p.initialize(Interval(0, 5));
+    for (uint32_t prg_id = 0; prg_id != 3; ++prg_id)
+        idx.add_record(1, prg_id, p, 0, 0);
+    idx.add_record(2, 0, p, 0, 0);
+    for (uint32_t prg_id = 0; prg_id != 2; ++prg_id)
+        idx.add_record(3, prg_id, p, 0, 0);
+
+    idx.mask_frequent_minimizers(0);
+    EXPECT_TRUE(idx.is_frozen());
+    EXPECT_FALSE(idx.is_masked(idx.find(1)));
+    EXPECT_FALSE(idx.is_masked(idx.find(2)));
+    EXPECT_FALSE(idx.is_masked(idx.find(3)));
+
+    idx.mask_frequent_minimizers(2);
+    EXPECT_EQ((uint)2, idx.max_occurrences);
+    EXPECT_TRUE(idx.is_masked(idx.find(1)));
+    EXPECT_FALSE(idx.is_masked(idx.find(2)));
+    EXPECT_FALSE(idx.is_masked(idx.find(3)));
+
+    // the most frequent third of the minimizers
+    idx.mask_frequent_minimizers(0.34);
+    EXPECT_EQ((uint)2, idx.max_occurrences);
+    EXPECT_TRUE(idx.is_masked(idx.find(1)));
+    EXPECT_FALSE(idx.is_masked(idx.find(3)));
+
+    idx.mask_frequent_minimizers(1);
+    EXPECT_TRUE(idx.is_masked(idx.find(1)));
+    EXPECT_FALSE(idx.is_masked(idx.find(2)));
+    EXPECT_TRUE(idx.is_masked(idx.find(3)));
+}
+
+TEST(IndexTest, find_in_large_frozen_index) {
+    Index idx;
+    prg::Path p;
+    p.initialize(Interval(0, 15));
+    for (uint64_t kmer = 0; kmer < 100000; kmer += 3)
+        idx.add_record(kmer * 7919, kmer % 11, p, kmer % 13, kmer % 2);
+    idx.freeze();
+    for (uint64_t kmer = 0; kmer < 100000; ++kmer) {
+        auto records = idx.find(kmer * 7919);
+        if (kmer % 3 == 0) {
+            ASSERT_EQ((uint)1, records.size());
+            EXPECT_EQ(kmer % 11, records.first[0].prg_id);
+            EXPECT_EQ(kmer % 13, records.first[0].knode_id);
+        } else {
+            EXPECT_TRUE(records.empty());
+        }
+    }
+    EXPECT_TRUE(idx.find(std::numeric_limits<uint64_t>::max()).empty());
+}
+
+TEST(IndexTest, find_many) {
+    Index idx;
+    prg::Path p;
+    p.initialize(Interval(0, 15));
+    std::vector<uint64_t> kmers;
+    for (uint64_t kmer = 0; kmer < 10000; kmer += 3) {
+        idx.add_record(kmer * 7919, kmer % 11, p, kmer % 13, kmer % 2);
+        if (kmer % 2 == 0)
+            idx.add_record(kmer * 7919, kmer % 7, p, kmer % 5, kmer % 2);
+    }
+    for (uint64_t kmer = 10000; kmer != 0; --kmer)
+        kmers.push_back(kmer * 7919);
+    kmers.push_back(0);
+    kmers.push_back(std::numeric_limits<uint64_t>::max());
+
+    // same spans as looking up one at a time, while building and once frozen
+    std::vector<MiniRecordSpan> spans;
+    for (const auto frozen : {false, true}) {
+        if (frozen)
+            idx.freeze();
+        idx.find(kmers, spans);
+        ASSERT_EQ(kmers.size(), spans.size());
+        for (size_t i = 0; i != kmers.size(); ++i) {
+            const auto expected = idx.find(kmers[i]);
+            EXPECT_EQ(expected.first, spans[i].first);
+            EXPECT_EQ(expected.last, spans[i].last);
+            EXPECT_EQ(kmers[i] % 3 == 0 and kmers[i] <= 9999 * 7919, !spans[i].empty());
+        }
+    }
+
+    idx.find(std::vector<uint64_t>(), spans);
+    EXPECT_TRUE(spans.empty());
+}
+
+TEST(IndexTest, find_sorted) {
+    Index idx;
+    prg::Path p;
+    p.initialize(Interval(0, 15));
+    for (uint64_t kmer = 0; kmer < 10000; kmer += 3)
+        idx.add_record(kmer * 7919, kmer % 11, p, kmer % 13, kmer % 2);
+    // dense runs of kmers, repeats and gaps, so both the scan and the galloping are used
+    std::vector<uint64_t> kmers = {0, 0, 7919};
+    for (uint64_t kmer = 100; kmer != 200; ++kmer)
+        kmers.push_back(kmer * 7919);
+    for (uint64_t kmer = 300; kmer < 9999; kmer += 997)
+        kmers.push_back(kmer * 7919);
+    kmers.push_back(9999 * 7919);
+    kmers.push_back(12000 * 7919);
+    kmers.push_back(std::numeric_limits<uint64_t>::max());
+
+    std::vector<MiniRecordSpan> spans;
+    for (const auto frozen : {false, true}) {
+        if (frozen)
+            idx.freeze();
+        idx.find_sorted(kmers, spans);
+        ASSERT_EQ(kmers.size(), spans.size());
+        for (size_t i = 0; i != kmers.size(); ++i) {
+            const auto expected = idx.find(kmers[i]);
+            EXPECT_EQ(expected.first, spans[i].first);
+            EXPECT_EQ(expected.last, spans[i].last);
+        }
+    }
+
+    idx.find_sorted(std::vector<uint64_t>(), spans);
+    EXPECT_TRUE(spans.empty());
 }
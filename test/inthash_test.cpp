@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <stdint.h>
 #include <iostream>
+#include <random>
 
 
 using namespace std;
@@ -69,3 +70,22 @@ TEST(InthashTest, check1to1) {
     }
 }
 
+
+TEST(InthashTest, hash64_batch) {
+    std::mt19937_64 generator(5);
+    for (const auto isa : {Hash64Isa::scalar, Hash64Isa::sse2, Hash64Isa::avx2}) {
+        for (uint32_t k = 1; k <= 31; k += 5) {
+            const uint64_t mask = (1ULL << 2 * k) - 1;
+            // lengths which leave keys over after each vector width
+            for (uint32_t n = 0; n != 11; ++n) {
+                vector<uint64_t> keys(n), expected(n);
+                for (uint32_t i = 0; i != n; ++i) {
+                    keys[i] = generator() & mask;
+                    expected[i] = hash64(keys[i], mask);
+                }
+                hash64_batch(keys.data(), n, mask, isa);
+                EXPECT_EQ(expected, keys) << "k=" << k << " n=" << n << " isa=" << (int) isa;
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include "kmergraph_store.h"
+#include "localPRG.h"
+#include "index.h"
+#include "utils.h"
+#include <vector>
+#include <memory>
+#include <boost/filesystem.hpp>
+
+
+using namespace std;
+
+TEST(KmerGraphStoreTest, save_and_load) {
+    uint32_t w = 1, k = 3;
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    read_prg_file(prgs, "../../test/test_cases/prg0123.fa");
+    for (const auto &prg : prgs)
+        prg->minimizer_sketch(std::make_shared<Index>(), w, k);
+    const std::string dir = "kmergraph_store_test";
+    boost::filesystem::remove_all(dir);
+    save_kmergraph_store(prgs, dir, w, k);
+
+    const auto stores = find_kmergraph_stores(dir, w, k);
+    ASSERT_EQ((size_t) 1, stores.size());
+    KmerGraphStore store(stores[0]);
+    EXPECT_EQ((uint32_t) 0, store.first_id());
+    EXPECT_EQ((uint32_t) prgs.size(), store.end_id());
+    for (const auto &prg : prgs) {
+        EXPECT_TRUE(store.contains(prg->id));
+        EXPECT_EQ(prg->name, store.name(prg->id));
+        KmerGraph kmer_graph;
+        store.load(prg->id, kmer_graph);
+        EXPECT_EQ(prg->kmer_prg, kmer_graph);
+    }
+    EXPECT_FALSE(store.contains(prgs.size()));
+    EXPECT_TRUE(find_kmergraph_stores(dir, w, k + 1).empty());
+}
+
+TEST(KmerGraphStoreTest, append_and_load_stores) {
+    uint32_t w = 1, k = 3;
+    std::vector<std::shared_ptr<LocalPRG>> prgs, first_prgs, new_prgs;
+    read_prg_file(first_prgs, "../../test/test_cases/prg0123.fa");
+    read_prg_file(new_prgs, "../../test/test_cases/prg4567.fa", first_prgs.size());
+    prgs = first_prgs;
+    prgs.insert(prgs.end(), new_prgs.begin(), new_prgs.end());
+    for (const auto &prg : prgs)
+        prg->minimizer_sketch(std::make_shared<Index>(), w, k);
+
+    const std::string dir = "kmergraph_store_test_append";
+    boost::filesystem::remove_all(dir);
+    save_kmergraph_store(first_prgs, dir, w, k);
+    save_kmergraph_store(new_prgs, dir, w, k);
+    const auto stores = find_kmergraph_stores(dir, w, k);
+    ASSERT_EQ((size_t) 1, stores.size());
+    EXPECT_EQ((uint32_t) prgs.size(), KmerGraphStore(stores[0]).end_id());
+
+    std::vector<std::shared_ptr<LocalPRG>> read_prgs;
+    read_prg_file(read_prgs, "../../test/test_cases/prg0123.fa");
+    read_prg_file(read_prgs, "../../test/test_cases/prg4567.fa", read_prgs.size());
+    std::vector<bool> loaded(read_prgs.size(), false);
+    EXPECT_EQ((uint32_t) prgs.size(), load_kmergraph_stores(read_prgs, loaded, dir, w, k));
+    for (uint32_t i = 0; i != prgs.size(); ++i) {
+        EXPECT_TRUE(loaded[i]);
+        EXPECT_EQ(prgs[i]->kmer_prg, read_prgs[i]->kmer_prg);
+    }
+
+    // a store for the same PRG ids replaces the existing one
+    save_kmergraph_store(prgs, dir, w, k);
+    ASSERT_EQ((size_t) 1, find_kmergraph_stores(dir, w, k).size());
+}
+
+TEST(KmerGraphStoreTest, load_wrong_prg_names) {
+    uint32_t w = 1, k = 3;
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    read_prg_file(prgs, "../../test/test_cases/prg0123.fa");
+    for (const auto &prg : prgs)
+        prg->minimizer_sketch(std::make_shared<Index>(), w, k);
+    const std::string dir = "kmergraph_store_test_names";
+    boost::filesystem::remove_all(dir);
+    save_kmergraph_store(prgs, dir, w, k);
+
+    std::vector<std::shared_ptr<LocalPRG>> other_prgs;
+    read_prg_file(other_prgs, "../../test/test_cases/prg4567.fa");
+    std::vector<bool> loaded(other_prgs.size(), false);
+    EXPECT_DEATH(load_kmergraph_stores(other_prgs, loaded, dir, w, k), "");
+}
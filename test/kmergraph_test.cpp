@@ -6,9 +6,12 @@
 #include "kmergraph.h"
 #include "kmernode.h"
 #include "localPRG.h"
+#include "index.h"
+#include "utils.h"
 #include <stdint.h>
 #include <iostream>
 #include <cmath>
+#include <fstream>
 
 
 using namespace std;
@@ -24,7 +27,7 @@ TEST(KmerGraphTest, add_node) {
     kg.add_node(p);
     uint j = 1;
     EXPECT_EQ(j, kg.nodes.size());
-    EXPECT_EQ(p, kg.nodes[0]->path);
+    EXPECT_EQ(p, kg.nodes[0]->path());
     j = 0;
     EXPECT_EQ(j, kg.nodes[0]->id);
     j = 1;
@@ -38,7 +41,7 @@ TEST(KmerGraphTest, add_node) {
     kg.add_node(p);
     j = 1;
     EXPECT_EQ(j, kg.nodes.size());
-    EXPECT_EQ(p, kg.nodes[0]->path);
+    EXPECT_EQ(p, kg.nodes[0]->path());
     j = 0;
     EXPECT_EQ(j, kg.nodes[0]->id);
     j = 1;
@@ -54,7 +57,7 @@ TEST(KmerGraphTest, add_node) {
     kg.add_node(p);
     j = 2;
     EXPECT_EQ(j, kg.nodes.size());
-    EXPECT_EQ(p, kg.nodes[1]->path);
+    EXPECT_EQ(p, kg.nodes[1]->path());
     j = 0;
     EXPECT_EQ(j, kg.nodes[0]->id);
     EXPECT_EQ(j, kg.nodes[0]->get_covg(0, sample_id));
@@ -64,6 +67,34 @@ TEST(KmerGraphTest, add_node) {
     EXPECT_EQ(j, kg.nodes[1]->id);
 }
 
+TEST(KmerGraphTest, find_node) {
+    KmerGraph kg;
+    prg::Path p1, p2, p3;
+    p1.initialize(Interval(0, 3));
+    p2.initialize(Interval(1, 4));
+    p3.initialize(Interval(2, 5));
+    auto n1 = kg.add_node(p1);
+    auto n2 = kg.add_node(p2);
+    EXPECT_EQ(n1, kg.find_node(prg::intern(p1)));
+    EXPECT_EQ(n2, kg.find_node(prg::intern(p2)));
+    EXPECT_EQ(nullptr, kg.find_node(prg::intern(p3)));
+    EXPECT_EQ(n2, kg.add_node(p2));
+    EXPECT_EQ((uint) 2, kg.nodes.size());
+
+    // the nodes of a copy are found in the copy
+    const KmerGraph copy(kg);
+    EXPECT_EQ(copy.nodes[1], copy.find_node(prg::intern(p2)));
+    KmerGraph assigned;
+    assigned.add_node(p3);
+    assigned = kg;
+    EXPECT_EQ(assigned.nodes[0], assigned.find_node(prg::intern(p1)));
+    EXPECT_EQ(nullptr, assigned.find_node(prg::intern(p3)));
+    kg.clear();
+    EXPECT_EQ(nullptr, kg.find_node(prg::intern(p1)));
+    n1 = kg.add_node(p1);
+    EXPECT_EQ(n1, kg.find_node(prg::intern(p1)));
+}
+
 TEST(KmerGraphTest, add_node_with_kh) {
     // add node and check it's there
     KmerGraph kg;
@@ -76,7 +107,7 @@ TEST(KmerGraphTest, add_node_with_kh) {
     kg.add_node_with_kh(p, kh);
     uint j = 1;
     EXPECT_EQ(j, kg.nodes.size());
-    EXPECT_EQ(p, kg.nodes[0]->path);
+    EXPECT_EQ(p, kg.nodes[0]->path());
     j = 0;
     EXPECT_EQ(j, kg.nodes[0]->id);
     j = 1;
@@ -300,7 +331,7 @@ TEST(KmerGraphTest, sort_topologically) {
     for (vector<KmerNodePtr>::iterator c = kg.sorted_nodes.begin(); c != kg.sorted_nodes.end(); ++c) {
         for (const auto &d: (*c)->outNodes) {
             it = c + 1;
-            while ((*it)->path != d->path and it != kg.sorted_nodes.end()) {
+            while ((*it)->path() != d->path() and it != kg.sorted_nodes.end()) {
                 it++;
             }
             EXPECT_EQ((it != kg.sorted_nodes.end()), true);
@@ -929,3 +960,126 @@ TEST(KmerGraphTest, load_prg) {
     KmerGraph read_kg;
     EXPECT_DEATH(read_kg.load("kmergraph_test.gfa"), "");
 }
+
+TEST(KmerGraphTest, load_fields) {
+    std::ofstream handle("kmergraph_test_fields.gfa");
+    handle << "H\tVN:Z:1.0\tbn:Z:--linear --singlearr\n"
+           << "S\t2\t1{[6, 9)}\tFC:i:3\t\tRC:i:4\t2\n"
+           << "S\t1\t2{[0, 1)[4, 6)}\tFC:i:0\t\tRC:i:12\n"
+           << "L\t1\t+\t2\t+\t0M\n"
+           << "S\t0\t1{[0, 0)}\tFC:i:0\t\tRC:i:0\n"
+           << "L\t0\t+\t1\t+\t0M\n"
+           << "L\t2\t-\t0\t+\t0M";
+    handle.close();
+
+    // nodes written in decreasing id order are reversed, and the last line needs no newline
+    KmerGraph read_kg;
+    read_kg.load("kmergraph_test_fields.gfa");
+    ASSERT_EQ((uint) 3, read_kg.nodes.size());
+    for (uint32_t i = 0; i != read_kg.nodes.size(); ++i) {
+        EXPECT_EQ(i, read_kg.nodes[i]->id);
+    }
+    prg::Path p;
+    p.initialize(std::vector<Interval>{Interval(0, 1), Interval(4, 6)});
+    EXPECT_EQ(p, read_kg.nodes[1]->path());
+    EXPECT_EQ(read_kg.nodes[1], read_kg.find_node(prg::intern(p)));
+    EXPECT_EQ((uint) 0, read_kg.nodes[1]->get_covg(0, 0));
+    EXPECT_EQ((uint) 12, read_kg.nodes[1]->get_covg(1, 0));
+    EXPECT_EQ((uint) 3, read_kg.nodes[2]->get_covg(0, 0));
+    EXPECT_EQ((uint) 4, read_kg.nodes[2]->get_covg(1, 0));
+    EXPECT_EQ((uint) 2, read_kg.nodes[2]->num_AT);
+    EXPECT_EQ((uint) 0, read_kg.nodes[1]->num_AT);
+    EXPECT_EQ(read_kg.nodes[0]->outNodes, (std::vector<KmerNodePtr>{read_kg.nodes[1], read_kg.nodes[2]}));
+    EXPECT_EQ(read_kg.nodes[1]->outNodes, (std::vector<KmerNodePtr>{read_kg.nodes[2]}));
+    EXPECT_EQ(read_kg.nodes[2]->inNodes, (std::vector<KmerNodePtr>{read_kg.nodes[1], read_kg.nodes[0]}));
+}
+
+TEST(KmerGraphTest, load_bad_fields) {
+    // lines which cannot be read end the program, however it was built
+    const std::vector<std::string> bad_lines = {"S\tx\t1{[0, 3)}\tFC:i:0\t\tRC:i:0",
+                                                "S\t0\t1{[0, 3)}\tFC:i:0",
+                                                "S\t0\t2{[0, 3)}\tFC:i:0\t\tRC:i:0",
+                                                "S\t0\t1{[0, 3)}\tFC:i:0\t\tRC:i:0\nL\t0\t+",
+                                                "S\t0\t1{[0, 3)}\tFC:i:0\t\tRC:i:0\nL\t0\t+\t1\t+\t0M"};
+    for (const auto &bad_line : bad_lines) {
+        std::ofstream handle("kmergraph_test_bad_fields.gfa");
+        handle << "H\tVN:Z:1.0\tbn:Z:--linear --singlearr\n" << bad_line << "\n";
+        handle.close();
+        KmerGraph read_kg;
+        EXPECT_EXIT(read_kg.load("kmergraph_test_bad_fields.gfa"), ::testing::ExitedWithCode(1),
+                    "Unable to read kmergraph file") << bad_line;
+    }
+    remove("kmergraph_test_bad_fields.gfa");
+}
+
+TEST(KmerGraphTest, load_saved_prg_graphs) {
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    read_prg_file(prgs, "../../test/test_cases/updatevcf_test.fa");
+    auto index = std::make_shared<Index>();
+    for (const auto &prg : prgs) {
+        prg->minimizer_sketch(index, 1, 15);
+        for (const auto &n : prg->kmer_prg.nodes) {
+            n->set_covg(n->id % 7, 0, 0);
+            n->set_covg(n->id % 5, 1, 0);
+        }
+        prg->kmer_prg.save("kmergraph_test_prg.gfa");
+
+        KmerGraph read_kg;
+        read_kg.load("kmergraph_test_prg.gfa");
+        EXPECT_EQ(prg->kmer_prg, read_kg);
+        ASSERT_EQ(prg->kmer_prg.nodes.size(), read_kg.nodes.size());
+        for (uint32_t i = 0; i != read_kg.nodes.size(); ++i) {
+            const auto &n = prg->kmer_prg.nodes[i], &read_n = read_kg.nodes[i];
+            EXPECT_EQ(n->path(), read_n->path());
+            EXPECT_EQ(n->get_covg(0, 0), read_n->get_covg(0, 0));
+            EXPECT_EQ(n->get_covg(1, 0), read_n->get_covg(1, 0));
+            ASSERT_EQ(n->inNodes.size(), read_n->inNodes.size());
+            for (uint32_t j = 0; j != n->inNodes.size(); ++j) {
+                EXPECT_EQ(n->inNodes[j]->id, read_n->inNodes[j]->id);
+            }
+        }
+    }
+}
+
+TEST(KmerGraphTest, encode_decode) {
+    KmerGraph kg, read_kg;
+    deque<Interval> d = {Interval(0, 0)};
+    prg::Path p;
+    p.initialize(d);
+    auto n0 = kg.add_node(p);
+    d = {Interval(0, 3)};
+    p.initialize(d);
+    auto n1 = kg.add_node(p);
+    d = {Interval(1, 2), Interval(200, 202)};
+    p.initialize(d);
+    auto n2 = kg.add_node(p);
+    d = {Interval(300, 300)};
+    p.initialize(d);
+    auto n3 = kg.add_node(p);
+    kg.add_edge(n0, n1);
+    kg.add_edge(n1, n2);
+    kg.add_edge(n2, n3);
+    kg.add_edge(n1, n3);
+    kg.setup_coverages(1);
+    kg.nodes[1]->set_covg(5, 1, 0);
+    kg.nodes[2]->set_covg(300, 0, 0);
+
+    std::string buffer;
+    kg.encode(buffer);
+    const char *data = buffer.data();
+    EXPECT_TRUE(read_kg.decode(data, buffer.data() + buffer.size()));
+    EXPECT_EQ(buffer.data() + buffer.size(), data);
+    EXPECT_EQ(kg, read_kg);
+    for (uint32_t i = 0; i != kg.nodes.size(); ++i) {
+        EXPECT_EQ(kg.nodes[i]->path(), read_kg.nodes[i]->path());
+        EXPECT_EQ(kg.nodes[i]->get_covg(0, 0), read_kg.nodes[i]->get_covg(0, 0));
+        EXPECT_EQ(kg.nodes[i]->get_covg(1, 0), read_kg.nodes[i]->get_covg(1, 0));
+    }
+    EXPECT_EQ(read_kg.nodes[1]->outNodes, (std::vector<KmerNodePtr>{read_kg.nodes[2], read_kg.nodes[3]}));
+    // in edges come in the order of their source node, as when loading the GFA
+    EXPECT_EQ(read_kg.nodes[3]->inNodes, (std::vector<KmerNodePtr>{read_kg.nodes[1], read_kg.nodes[2]}));
+
+    // truncated data is rejected
+    data = buffer.data();
+    EXPECT_FALSE(read_kg.decode(data, buffer.data() + buffer.size() - 1));
+}
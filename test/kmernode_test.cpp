@@ -22,7 +22,7 @@ TEST(KmerNodeTest, create) {
     EXPECT_EQ(j, kn.get_covg(0, 0));
     EXPECT_EQ(j, kn.get_covg(0, 0));
     EXPECT_EQ(j, kn.num_AT);
-    EXPECT_EQ(p, kn.path);
+    EXPECT_EQ(p, kn.path());
 }
 
 TEST(KmerNodeTest, assign) {
@@ -40,7 +40,7 @@ TEST(KmerNodeTest, assign) {
     EXPECT_EQ((uint)1, kn.get_covg(0, 0));
     EXPECT_EQ((uint)2, kn.get_covg(1, 0));
     EXPECT_EQ((uint)0, kn.num_AT);
-    EXPECT_EQ(p, kn.path);
+    EXPECT_EQ(p, kn.path());
 
     KmerNode kn_prime = kn;
 
@@ -49,7 +49,7 @@ TEST(KmerNodeTest, assign) {
     EXPECT_EQ((uint)1, kn_prime.get_covg(0, 0));
     EXPECT_EQ((uint)2, kn_prime.get_covg(1, 0));
     EXPECT_EQ((uint)0, kn_prime.num_AT);
-    EXPECT_EQ(p, kn.path);
+    EXPECT_EQ(p, kn.path());
 }
 
 TEST(KmerNodeTest, equals) {
@@ -665,7 +665,7 @@ TEST(LocalPRGTest, minimizer_sketch_SameAsSeqw1) {
     lit++;
 
     for (auto sit = sketch.begin(); sit != sketch.end(); ++sit) {
-        EXPECT_EQ((*sit).pos, (*lit)->path.path[0]);
+        EXPECT_EQ((*sit).pos, (*lit)->path().path[0]);
         ++lit;
     }
 }
@@ -687,7 +687,7 @@ TEST(LocalPRGTest, minimizer_sketch_SameAsSeqw5) {
     lit++;
 
     for (auto sit = sketch.begin(); sit != sketch.end(); ++sit) {
-        EXPECT_EQ((*sit).pos, (*lit)->path.path[0]);
+        EXPECT_EQ((*sit).pos, (*lit)->path().path[0]);
         ++lit;
     }
 }
@@ -709,7 +709,7 @@ TEST(LocalPRGTest, minimizer_sketch_SameAsSeqw10) {
     lit++;
 
     for (auto sit = sketch.begin(); sit != sketch.end(); ++sit) {
-        EXPECT_EQ((*sit).pos, (*lit)->path.path[0]);
+        EXPECT_EQ((*sit).pos, (*lit)->path().path[0]);
         ++lit;
     }
 }
@@ -731,7 +731,7 @@ TEST(LocalPRGTest, minimizer_sketch_SameAsSeqw15) {
     lit++;
 
     for (auto sit = sketch.begin(); sit != sketch.end(); ++sit) {
-        EXPECT_EQ((*sit).pos, (*lit)->path.path[0]);
+        EXPECT_EQ((*sit).pos, (*lit)->path().path[0]);
         ++lit;
     }
 }
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "localgraph_store.h"
+#include "localPRG.h"
+#include "index.h"
+#include "utils.h"
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+
+using namespace std;
+
+TEST(LocalGraphStoreTest, save_and_load) {
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    read_prg_file(prgs, "../../test/test_cases/prg0123.fa");
+    read_prg_file(prgs, "../../test/test_cases/updatevcf_test.fa", prgs.size());
+    save_localgraph_store(prgs, "localgraph_store_test.bin");
+
+    LocalGraphStore store("localgraph_store_test.bin");
+    EXPECT_TRUE(store.is_valid());
+    ASSERT_EQ((uint32_t) prgs.size(), store.size());
+    for (uint32_t i = 0; i != prgs.size(); ++i) {
+        const auto &prg = prgs[i];
+        auto loaded = store.load(i, prg->id, prg->name, prg->seq);
+        ASSERT_NE(nullptr, loaded);
+        EXPECT_EQ(prg->id, loaded->id);
+        EXPECT_EQ(prg->name, loaded->name);
+        // LocalGraph::operator== compares every path, which is too slow for the larger PRGs
+        ASSERT_EQ(prg->prg.nodes.size(), loaded->prg.nodes.size());
+        for (const auto &node : prg->prg.nodes) {
+            const auto &loaded_node = loaded->prg.nodes[node.first];
+            EXPECT_EQ(node.second->id, loaded_node->id);
+            EXPECT_EQ(node.second->pos, loaded_node->pos);
+            EXPECT_EQ(node.second->seq, loaded_node->seq);
+            ASSERT_EQ(node.second->outNodes.size(), loaded_node->outNodes.size());
+            for (uint32_t j = 0; j != node.second->outNodes.size(); ++j) {
+                EXPECT_EQ(node.second->outNodes[j]->id, loaded_node->outNodes[j]->id);
+            }
+        }
+        EXPECT_EQ(prg->prg.startIndexOfAllIntervals.size(), loaded->prg.startIndexOfAllIntervals.size());
+        EXPECT_EQ(prg->prg.startIndexOfZeroLengthIntervals.size(),
+                  loaded->prg.startIndexOfZeroLengthIntervals.size());
+
+        // sketching walks the interval tree, so gives the same kmer graph only if it was rebuilt the same
+        auto index = std::make_shared<Index>(), loaded_index = std::make_shared<Index>();
+        prg->minimizer_sketch(index, 14, 15);
+        loaded->minimizer_sketch(loaded_index, 14, 15);
+        EXPECT_EQ(prg->kmer_prg, loaded->kmer_prg);
+        EXPECT_EQ(*index, *loaded_index);
+    }
+
+    // the store does not match PRGs with another name or sequence, or past its end
+    EXPECT_EQ(nullptr, store.load(0, 0, prgs[1]->name, prgs[0]->seq));
+    EXPECT_EQ(nullptr, store.load(0, 0, prgs[0]->name, prgs[0]->seq + "A"));
+    EXPECT_EQ(nullptr, store.load(prgs.size(), 0, prgs[0]->name, prgs[0]->seq));
+}
+
+TEST(LocalGraphStoreTest, read_prg_file_with_store) {
+    boost::filesystem::copy_file("../../test/test_cases/prg0123.fa", "localgraph_store_test.fa",
+                                 boost::filesystem::copy_option::overwrite_if_exists);
+    std::vector<std::shared_ptr<LocalPRG>> prgs, built_prgs;
+    read_prg_file(built_prgs, "localgraph_store_test.fa", 5);
+    save_localgraph_store(built_prgs, localgraph_store_path("localgraph_store_test.fa"));
+
+    read_prg_file(prgs, "localgraph_store_test.fa", 5);
+    ASSERT_EQ(built_prgs.size(), prgs.size());
+    for (uint32_t i = 0; i != prgs.size(); ++i) {
+        EXPECT_EQ(built_prgs[i]->id, prgs[i]->id);
+        EXPECT_EQ(built_prgs[i]->name, prgs[i]->name);
+        EXPECT_EQ(built_prgs[i]->seq, prgs[i]->seq);
+        EXPECT_EQ(built_prgs[i]->prg, prgs[i]->prg);
+    }
+
+    // PRGs edited or added since the store was written are built from their strings
+    std::ofstream handle("localgraph_store_test.fa");
+    handle << ">" << built_prgs[0]->name << "\n" << built_prgs[0]->seq << "\n"
+           << ">" << built_prgs[1]->name << "\n" << "ACGT 5 G 6 T 5 " << "\n"
+           << ">" << built_prgs[2]->name << "\n" << built_prgs[2]->seq << "\n"
+           << ">new\n" << built_prgs[1]->seq << "\n";
+    handle.close();
+    prgs.clear();
+    read_prg_file(prgs, "localgraph_store_test.fa");
+    ASSERT_EQ((size_t) 4, prgs.size());
+    EXPECT_EQ(built_prgs[0]->prg, prgs[0]->prg);
+    EXPECT_EQ(LocalPRG(1, built_prgs[1]->name, "ACGT 5 G 6 T 5 ").prg, prgs[1]->prg);
+    EXPECT_EQ(built_prgs[2]->prg, prgs[2]->prg);
+    EXPECT_EQ(built_prgs[1]->prg, prgs[3]->prg);
+    EXPECT_EQ((uint32_t) 3, prgs[3]->id);
+}
+
+TEST(LocalGraphStoreTest, invalid_store_is_ignored) {
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    read_prg_file(prgs, "../../test/test_cases/prg0123.fa");
+    save_localgraph_store(prgs, "localgraph_store_test.bin");
+    boost::filesystem::resize_file("localgraph_store_test.bin",
+                                   boost::filesystem::file_size("localgraph_store_test.bin") - 8);
+    {
+        LocalGraphStore truncated("localgraph_store_test.bin");
+        EXPECT_FALSE(truncated.is_valid());
+        EXPECT_EQ(nullptr, truncated.load(0, 0, prgs[0]->name, prgs[0]->seq));
+    }
+
+    std::ofstream handle("localgraph_store_test.bin", std::ios::binary | std::ios::trunc);
+    handle << "not a local graph store at all";
+    handle.close();
+    LocalGraphStore other("localgraph_store_test.bin");
+    EXPECT_FALSE(other.is_valid());
+}
@@ -281,6 +281,49 @@ TEST(LocalGraphTest, walk) {
     EXPECT_ITERABLE_EQ(vector<prg::Path>, q1, p1);
 }
 
+TEST(LocalGraphTest, walk_with_cache) {
+    LocalGraph lg3;
+    lg3.add_node(0, "A", Interval(0, 1));
+    lg3.add_node(1, "G", Interval(4, 5));
+    lg3.add_node(2, "C", Interval(8, 9));
+    lg3.add_node(3, "T", Interval(12, 13));
+    lg3.add_node(4, "", Interval(16, 16));
+    lg3.add_node(5, "G", Interval(19, 20));
+    lg3.add_node(6, "T", Interval(23, 24));
+    lg3.add_edge(0, 1);
+    lg3.add_edge(0, 5);
+    lg3.add_edge(1, 2);
+    lg3.add_edge(1, 3);
+    lg3.add_edge(2, 4);
+    lg3.add_edge(3, 4);
+    lg3.add_edge(4, 6);
+    lg3.add_edge(5, 6);
+
+    // memoized walks are the walks, whether or not they come from the cache, even when it is too small to hold them all
+    WalkCache cache(100), small_cache(2);
+    uint64_t first_round_hits = 0, first_round_misses = 0;
+    for (uint32_t round = 0; round != 2; ++round) {
+        if (round == 1) {
+            first_round_hits = cache.hits;
+            first_round_misses = cache.misses;
+        }
+        for (const auto &node : lg3.nodes) {
+            for (uint32_t len = 1; len != 6; ++len) {
+                const auto expected = lg3.walk(node.first, node.second->pos.start, len);
+                EXPECT_ITERABLE_EQ(vector<prg::Path>, expected, lg3.walk(node.first, node.second->pos.start, len, &cache));
+                EXPECT_ITERABLE_EQ(vector<prg::Path>, expected,
+                                   lg3.walk(node.first, node.second->pos.start, len, &small_cache));
+                EXPECT_LE(small_cache.size(), (size_t) 2);
+                EXPECT_LE(small_cache.stored_size(), (size_t) 2); //paths, as a walk may have several
+            }
+        }
+    }
+    // walks from the start share the walks on from later nodes, and the second round finds every walk in the cache
+    EXPECT_LT((uint64_t) 0, first_round_hits);
+    EXPECT_EQ(first_round_hits + 7 * 5, cache.hits);
+    EXPECT_EQ(first_round_misses, cache.misses);
+}
+
 TEST(LocalGraphTest, walk_back) {
     LocalGraph lg2;
     lg2.add_node(0, "A", Interval(0, 1));
@@ -0,0 +1,71 @@
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fastaq_reader.h"
+#include "mapped_fastaq_reader.h"
+
+
+using namespace std;
+
+static void expect_same_records_as_fastaq_reader(const string &filepath) {
+    ReadIndexBuilder expected_index, index;
+    vector<FastaqRecord> expected, batch;
+    {
+        FastaqReader reader(filepath, &expected_index);
+        while (reader.next_batch(batch))
+            expected.insert(expected.end(), batch.begin(), batch.end());
+    }
+
+    MappedFastaqReader reader(filepath, &index);
+    FastaqRecordView record;
+    uint32_t i = 0;
+    while (reader.next(record)) {
+        ASSERT_LT(i, expected.size());
+        EXPECT_EQ(expected[i].id, record.id);
+        EXPECT_EQ(expected[i].name, record.name.to_string());
+        EXPECT_EQ(expected[i].seq, record.seq.to_string());
+        ++i;
+    }
+    EXPECT_EQ(expected.size(), i);
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_FALSE(index.gzipped);
+    EXPECT_EQ(expected_index.read_offsets, index.read_offsets);
+}
+
+TEST(MappedFastaqReaderTest, same_records_as_fastaq_reader) {
+    expect_same_records_as_fastaq_reader("../../test/test_cases/reads.fa");
+    expect_same_records_as_fastaq_reader("../../test/test_cases/reads.fq");
+}
+
+TEST(MappedFastaqReaderTest, awkward_records) {
+    ofstream handle("mapped_fastaq_reader_test.fq");
+    handle << "junk before the first read\n"
+           << "@read0 with a comment\r\nACGT\r\n+\r\n@@@@\r\n"
+           << "@read1\nACGTACGT\n+read1\n@@@@\nIIII\n"
+           << "@empty\n\n+\n\n"
+           << "\n@read3\nAC\nGT\n+\n>>>>\n"
+           << ">read4\nAC\r\nGT\r\nTT\n\n"
+           << "@read5\nTTTT\n+\nIIII";
+    handle.close();
+    expect_same_records_as_fastaq_reader("mapped_fastaq_reader_test.fq");
+
+    MappedFastaqReader reader("mapped_fastaq_reader_test.fq");
+    FastaqRecordView record;
+    const vector<pair<string, string>> expected = {{"read0 with a comment", "ACGT"}, {"read1", "ACGTACGT"},
+                                                   {"empty", ""}, {"read3", "ACGT"}, {"read4", "ACGTTT"},
+                                                   {"read5", "TTTT"}};
+    for (uint32_t i = 0; i != expected.size(); ++i) {
+        ASSERT_TRUE(reader.next(record));
+        EXPECT_EQ(expected[i].first, record.name.to_string());
+        EXPECT_EQ(expected[i].second, record.seq.to_string());
+    }
+    EXPECT_FALSE(reader.next(record));
+}
+
+TEST(MappedFastaqReaderTest, empty_file_has_no_records) {
+    ofstream("mapped_fastaq_reader_test_empty.fa").close();
+    MappedFastaqReader reader("mapped_fastaq_reader_test_empty.fa");
+    FastaqRecordView record;
+    EXPECT_FALSE(reader.next(record));
+}
@@ -28,7 +28,7 @@ TEST(MinimizerHitTest, create) {
     EXPECT_EQ((uint) 0, mh.read_start_position);
     j = 0;
     EXPECT_EQ(j, mh.prg_id);
-    EXPECT_EQ(p, mh.prg_path);
+    EXPECT_EQ(p, mh.prg_path());
     bool b = true;
     EXPECT_EQ(b, mh.is_forward);
 
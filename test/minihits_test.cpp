@@ -57,6 +57,54 @@ TEST(MinimizerHitsTest, add_hit) {
     delete mr;
 }
 
+TEST(MinimizerHitsTest, clear_keeps_hits_still_pointed_to) {
+    // hits are made in blocks, so enough of them to fill more than one
+    MinimizerHits mhits;
+    KmerHash hash;
+    pair<uint64_t, uint64_t> kh = hash.kmerhash("ACGTA", 5);
+    prg::Path p;
+    p.initialize(Interval(0, 5));
+    MiniRecord mr(0, p, 0, 0);
+    for (uint32_t i = 0; i != 5000; ++i)
+        mhits.add_hit(i, Minimizer(min(kh.first, kh.second), i, i + 5, 0), &mr);
+    mhits.sort();
+    const auto kept = mhits.hits;
+    mhits.clear();
+    EXPECT_EQ((uint) 0, mhits.uhits.size());
+
+    for (uint32_t i = 0; i != 5000; ++i)
+        mhits.add_hit(i + 5000, Minimizer(min(kh.first, kh.second), i, i + 5, 0), &mr);
+    uint32_t i = 0;
+    for (const auto &hit : kept) {
+        EXPECT_EQ(i, hit->read_id);
+        EXPECT_EQ(i, hit->read_start_position);
+        ++i;
+    }
+    EXPECT_EQ((uint) 5000, i);
+}
+
+TEST(MinimizerHitsTest, clear_does_not_reuse_hits_still_pointed_to) {
+    // fewer hits than a block, so those added after clear() go in the same block as those kept
+    MinimizerHits mhits;
+    KmerHash hash;
+    pair<uint64_t, uint64_t> kh = hash.kmerhash("ACGTA", 5);
+    prg::Path p;
+    p.initialize(Interval(0, 5));
+    MiniRecord mr(0, p, 0, 0);
+    for (uint32_t i = 0; i != 10; ++i)
+        mhits.add_hit(i, Minimizer(min(kh.first, kh.second), i, i + 5, 0), &mr);
+    const auto kept = mhits.uhits;
+    mhits.clear();
+
+    for (uint32_t i = 0; i != 10; ++i)
+        mhits.add_hit(i + 10, Minimizer(min(kh.first, kh.second), i + 10, i + 15, 0), &mr);
+    for (uint32_t i = 0; i != 10; ++i) {
+        EXPECT_EQ(i, kept[i]->read_id);
+        EXPECT_EQ(i, kept[i]->read_start_position);
+        EXPECT_EQ(i + 10, mhits.uhits[i]->read_id);
+    }
+}
+
 TEST(MinimizerHitsTest, pComp) {
     MinimizerHits mhits;
     vector<MinimizerHit> expected;
@@ -18,22 +18,22 @@ TEST(MiniRecordTest, create) {
     MiniRecord m1(1, p, 0, 0);
     uint32_t j = 1;
     EXPECT_EQ(j, m1.prg_id);
-    EXPECT_EQ(p, m1.path);
+    EXPECT_EQ(p, m1.path());
     p.initialize(v2);
     MiniRecord m2(2, p, 0, 0);
     j = 2;
     EXPECT_EQ(j, m2.prg_id);
-    EXPECT_EQ(p, m2.path);
+    EXPECT_EQ(p, m2.path());
     p.initialize(v3);
     MiniRecord m3(3, p, 0, 0);
     j = 3;
     EXPECT_EQ(j, m3.prg_id);
-    EXPECT_EQ(p, m3.path);
+    EXPECT_EQ(p, m3.path());
     p.initialize(v4);
     MiniRecord m4(4, p, 0, 0);
     j = 4;
     EXPECT_EQ(j, m4.prg_id);
-    EXPECT_EQ(p, m4.path);
+    EXPECT_EQ(p, m4.path());
 }
 
 TEST(MiniRecordTest, equals) {
@@ -87,6 +87,31 @@ TEST(ReadAddHits, AddSecondCluster_ReadHitsMapContainsCorrectPrgIds) {
     EXPECT_TRUE(result);
 }
 
+TEST(ReadAddHits, AddSecondClusterForSamePrg_ReadHitsOrderedByPath) {
+    uint32_t read_id = 1;
+    Read read(read_id);
+    uint32_t prg_id = 4;
+    std::deque<Interval> raw_path = {Interval(7, 8), Interval(10, 14)};
+    prg::Path later_path;
+    later_path.initialize(raw_path);
+    raw_path = {Interval(0, 5)};
+    prg::Path earlier_path;
+    earlier_path.initialize(raw_path);
+
+    std::set<MinimizerHitPtr, pComp> cluster;
+    cluster.insert(std::make_shared<MinimizerHit>(read_id, Interval(0, 5), prg_id, later_path, 0, 1));
+    read.add_hits(prg_id, cluster);
+    cluster.clear();
+    cluster.insert(std::make_shared<MinimizerHit>(read_id, Interval(20, 25), prg_id, later_path, 0, 0));
+    cluster.insert(std::make_shared<MinimizerHit>(read_id, Interval(30, 35), prg_id, earlier_path, 1, 1));
+    read.add_hits(prg_id, cluster);
+
+    const std::vector<MinimizerHit> expect = {MinimizerHit(read_id, Interval(30, 35), prg_id, earlier_path, 1, 1),
+                                              MinimizerHit(read_id, Interval(0, 5), prg_id, later_path, 0, 1),
+                                              MinimizerHit(read_id, Interval(20, 25), prg_id, later_path, 0, 0)};
+    EXPECT_EQ(expect, read.hits[prg_id]);
+}
+
 TEST(PangenomeReadTest, find_position) {
     std::set<MinimizerHitPtr, pComp> mhs;
 
@@ -2,8 +2,11 @@
 #include "test_macro.cpp"
 #include "interval.h"
 #include "prg/path.h"
+#include "prg/path_pool.h"
 #include <stdint.h>
 #include <iostream>
+#include <set>
+#include <thread>
 
 
 typedef prg::Path Path;
@@ -327,3 +330,66 @@ TEST(PathTest, get_union) {
     p2.initialize(d2);
     EXPECT_DEATH(get_union(p1, p2), "");
 }
+
+TEST(PathPoolTest, intern_equal_paths_share_id) {
+    Path p, q, r;
+    vector<Interval> d = {Interval(0, 1), Interval(3, 3), Interval(5, 10)};
+    p.initialize(d);
+    q.initialize(d);
+    d = {Interval(0, 1), Interval(5, 10)};
+    r.initialize(d);
+
+    const auto size = PathPool::instance().size();
+    const auto p_id = intern(p);
+    EXPECT_EQ(p_id, intern(q));
+    EXPECT_NE(p_id, intern(r));
+    EXPECT_EQ(p_id, intern(p));
+    EXPECT_LE(PathPool::instance().size(), size + 2);
+
+    EXPECT_EQ(p, get_path(p_id));
+    EXPECT_EQ(r, get_path(intern(r)));
+}
+
+TEST(PathPoolTest, less_matches_path_order) {
+    Path p, q;
+    vector<Interval> d = {Interval(0, 1), Interval(3, 3), Interval(5, 10)};
+    p.initialize(d);
+    d = {Interval(0, 1), Interval(4, 10)};
+    q.initialize(d);
+    const auto p_id = intern(p);
+    const auto q_id = intern(q);
+
+    const auto &pool = PathPool::instance();
+    EXPECT_EQ(p < q, pool.less(p_id, q_id));
+    EXPECT_EQ(q < p, pool.less(q_id, p_id));
+    EXPECT_FALSE(pool.less(p_id, p_id));
+}
+
+TEST(PathPoolTest, intern_from_several_threads) {
+    // each thread interns the same paths, starting at a different one
+    const uint32_t num_threads = 4, num_paths = 5000;
+    vector<vector<PathId>> ids(num_threads, vector<PathId>(num_paths));
+    vector<thread> threads;
+    for (uint32_t t = 0; t != num_threads; ++t) {
+        threads.emplace_back([&ids, t]() {
+            for (uint32_t j = 0; j != num_paths; ++j) {
+                const auto i = (j + t * 1237) % num_paths;
+                Path p;
+                p.initialize(vector<Interval>{Interval(i, i + 3), Interval(1000000 + i, 1000000 + i + 12)});
+                ids[t][i] = intern(p);
+            }
+        });
+    }
+    for (auto &worker : threads)
+        worker.join();
+
+    // equal ids for equal paths, and distinct ids for distinct paths
+    for (uint32_t i = 0; i != num_paths; ++i) {
+        Path p;
+        p.initialize(vector<Interval>{Interval(i, i + 3), Interval(1000000 + i, 1000000 + i + 12)});
+        EXPECT_EQ(p, get_path(ids[0][i]));
+        for (uint32_t t = 1; t != num_threads; ++t)
+            EXPECT_EQ(ids[0][i], ids[t][i]);
+    }
+    EXPECT_EQ((size_t) num_paths, set<PathId>(ids[0].begin(), ids[0].end()).size());
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include "gtest/gtest.h"
+#include "fastaq_handler.h"
+#include "fastaq_reader.h"
+#include "read_index.h"
+
+
+using namespace std;
+
+// FASTQ text of reads of random lengths and bases
+static string random_reads(const uint32_t num_reads, vector<pair<string, string>> &reads) {
+    std::mt19937 generator(1);
+    string text;
+    for (uint32_t i = 0; i != num_reads; ++i) {
+        string seq(50 + generator() % 500, 'A');
+        for (auto &c : seq)
+            c = "ACGT"[generator() % 4];
+        reads.emplace_back("read" + to_string(i), seq);
+        text += "@" + reads.back().first + "\n" + seq + "\n+\n" + string(seq.size(), 'I') + "\n";
+    }
+    return text;
+}
+
+static string gzip(const string &text) {
+    ostringstream compressed;
+    {
+        boost::iostreams::filtering_ostream out;
+        out.push(boost::iostreams::gzip_compressor());
+        out.push(compressed);
+        out << text;
+    }
+    return compressed.str();
+}
+
+static void build_read_index(const string &filepath, const uint64_t checkpoint_span, ReadIndexBuilder &builder) {
+    builder.checkpoint_span = checkpoint_span;
+    FastaqReader reader(filepath, &builder);
+    vector<FastaqRecord> batch;
+    while (reader.next_batch(batch));
+    reader.close();
+    builder.save(filepath, read_index_path(filepath, "."));
+}
+
+static void expect_get_id_finds_reads(const string &filepath, const vector<pair<string, string>> &reads) {
+    EXPECT_EQ(nullptr, FastaqHandler(filepath).read_index);
+    FastaqHandler fh(filepath, read_index_path(filepath, "."));
+    EXPECT_NE(nullptr, fh.read_index);
+    vector<uint32_t> ids;
+    for (uint32_t id = 0; id < reads.size(); id += 7)
+        ids.push_back(id);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(2));
+    ids.push_back(ids.back() + 1);
+    ids.push_back(0);
+    for (const auto id : ids) {
+        fh.get_id(id);
+        EXPECT_EQ(id + 1, fh.num_reads_parsed);
+        EXPECT_EQ(reads[id].first, fh.name);
+        EXPECT_EQ(reads[id].second, fh.read);
+    }
+}
+
+TEST(ReadIndexTest, get_id_seeks_in_plain_file) {
+    vector<pair<string, string>> reads;
+    ofstream("read_index_test.fq") << random_reads(5000, reads);
+    ReadIndexBuilder builder;
+    build_read_index("read_index_test.fq", 1 << 16, builder);
+    EXPECT_FALSE(builder.gzipped);
+    EXPECT_EQ(reads.size(), builder.read_offsets.size());
+    EXPECT_TRUE(builder.checkpoints.empty());
+
+    ReadIndex read_index("read_index_test.fq", read_index_path("read_index_test.fq", "."));
+    ASSERT_TRUE(read_index.is_valid());
+    EXPECT_EQ(reads.size(), read_index.num_reads());
+    EXPECT_EQ((uint64_t) 0, read_index.read_offset(0));
+    expect_get_id_finds_reads("read_index_test.fq", reads);
+}
+
+TEST(ReadIndexTest, get_id_seeks_in_gzipped_file) {
+    vector<pair<string, string>> reads;
+    const auto text = random_reads(5000, reads);
+    ofstream("read_index_test.fq.gz", ios::binary) << gzip(text);
+    ReadIndexBuilder builder;
+    build_read_index("read_index_test.fq.gz", 1 << 16, builder);
+    EXPECT_TRUE(builder.gzipped);
+    EXPECT_EQ(reads.size(), builder.read_offsets.size());
+    EXPECT_GT(builder.checkpoints.size(), (size_t) 5);
+
+    // decompressing from any checkpoint gives the same as from the start
+    ReadIndex read_index("read_index_test.fq.gz", read_index_path("read_index_test.fq.gz", "."));
+    ASSERT_TRUE(read_index.is_valid());
+    for (const auto &checkpoint : builder.checkpoints) {
+        EXPECT_EQ(&read_index.checkpoint_before(checkpoint.uncompressed_offset + 10)
+                  - &read_index.checkpoint_before(0), &checkpoint - &builder.checkpoints[0]);
+        ifstream file("read_index_test.fq.gz", ios::binary);
+        GzipInflater inflater(file, checkpoint, read_index.window(checkpoint));
+        string decompressed(1000, '\0');
+        decompressed.resize(inflater.read(&decompressed[0], decompressed.size()));
+        EXPECT_EQ(text.substr(checkpoint.uncompressed_offset, 1000), decompressed);
+    }
+    expect_get_id_finds_reads("read_index_test.fq.gz", reads);
+}
+
+TEST(ReadIndexTest, get_id_seeks_in_multi_member_gzipped_file) {
+    // as written by bgzip, each member is a gzip file of its own
+    vector<pair<string, string>> reads;
+    const auto text = random_reads(3000, reads);
+    string compressed;
+    for (size_t start = 0; start < text.size(); start += 100000)
+        compressed += gzip(text.substr(start, 100000));
+    ofstream("read_index_test_members.fq.gz", ios::binary) << compressed;
+    ReadIndexBuilder builder;
+    build_read_index("read_index_test_members.fq.gz", 1 << 16, builder);
+    EXPECT_EQ(reads.size(), builder.read_offsets.size());
+    uint32_t num_member_starts = 0;
+    for (const auto &checkpoint : builder.checkpoints) {
+        if (checkpoint.member_start) {
+            EXPECT_EQ((uint32_t) 0, checkpoint.window_size);
+            num_member_starts++;
+        }
+    }
+    EXPECT_GT(num_member_starts, (uint32_t) 1);
+    expect_get_id_finds_reads("read_index_test_members.fq.gz", reads);
+}
+
+TEST(ReadIndexTest, index_of_changed_file_is_ignored) {
+    vector<pair<string, string>> reads;
+    ofstream("read_index_test_changed.fq") << random_reads(100, reads);
+    ReadIndexBuilder builder;
+    build_read_index("read_index_test_changed.fq", 1 << 16, builder);
+    const auto index_filepath = read_index_path("read_index_test_changed.fq", ".");
+    EXPECT_TRUE(ReadIndex("read_index_test_changed.fq", index_filepath).is_valid());
+
+    ofstream("read_index_test_changed.fq", ios::app) << "@extra\nACGT\n+\nIIII\n";
+    EXPECT_FALSE(ReadIndex("read_index_test_changed.fq", index_filepath).is_valid());
+    FastaqHandler fh("read_index_test_changed.fq", index_filepath);
+    EXPECT_EQ(nullptr, fh.read_index);
+    fh.get_id(100);
+    EXPECT_EQ("extra", fh.name);
+    fh.get_id(3);
+    EXPECT_EQ(reads[3].second, fh.read);
+}
+
+TEST(ReadIndexTest, truncated_gzip_throws) {
+    vector<pair<string, string>> reads;
+    const auto compressed = gzip(random_reads(100, reads));
+    istringstream file(compressed.substr(0, compressed.size() / 2));
+    GzipInflater inflater(file);
+    string decompressed(1 << 20, '\0');
+    EXPECT_ANY_THROW(inflater.read(&decompressed[0], decompressed.size()));
+}
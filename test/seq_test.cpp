@@ -2,8 +2,11 @@
 #include "seq.h"
 #include "minimizer.h"
 #include "interval.h"
+#include "inthash.h"
 #include <stdint.h>
 #include <iostream>
+#include <set>
+#include <random>
 
 
 using namespace std;
@@ -83,3 +86,129 @@ TEST(SeqTest, sketchIncludesEveryLetter) {
 
 }
 
+
+// the sketch as it was computed before Seq::minimizer_sketch used a monotone window, erasing from the front of the window
+// and rescanning it whenever its smallest kmer left
+std::set<Minimizer> window_scan_sketch(const string &seq, const uint32_t w, const uint32_t k) {
+    std::set<Minimizer> sketch;
+    if (seq.length() + 1 < w + k)
+        return sketch;
+    uint64_t shift1 = 2 * (k - 1), mask = (1ULL << 2 * k) - 1, smallest = std::numeric_limits<uint64_t>::max(),
+            kmer[2] = {0, 0}, kh[2] = {0, 0};
+    uint32_t buff = 0;
+    vector<Minimizer> window;
+    for (const char letter : seq) {
+        uint32_t c = nt4((uint8_t) letter);
+        if (c >= 4)
+            return {};
+        kmer[0] = (kmer[0] << 2 | c) & mask;
+        kmer[1] = (kmer[1] >> 2) | (3ULL ^ c) << shift1;
+        kh[0] = hash64(kmer[0], mask);
+        kh[1] = hash64(kmer[1], mask);
+        buff++;
+        if (buff >= k)
+            window.push_back(Minimizer(std::min(kh[0], kh[1]), buff - k, buff, (kh[0] <= kh[1])));
+        if (window.size() == w) {
+            uint32_t pos_of_smallest = 0;
+            smallest = std::numeric_limits<uint64_t>::max();
+            for (uint32_t i = 0; i != window.size(); ++i) {
+                if (window[i].kmer <= smallest) {
+                    smallest = window[i].kmer;
+                    pos_of_smallest = i;
+                }
+            }
+            for (const auto &minimizer : window) {
+                if (minimizer.kmer == smallest)
+                    sketch.insert(minimizer);
+            }
+            window.erase(window.begin(), window.begin() + pos_of_smallest + 1);
+        } else if (buff >= w + k and window.back().kmer <= smallest) {
+            sketch.insert(window.back());
+            smallest = window.back().kmer;
+            window.clear();
+        }
+    }
+    return sketch;
+}
+
+string random_sequence(std::mt19937 &generator, const uint32_t length, const string &alphabet) {
+    std::uniform_int_distribution<uint32_t> letter(0, alphabet.size() - 1);
+    string seq(length, 'A');
+    for (auto &c : seq)
+        c = alphabet[letter(generator)];
+    return seq;
+}
+
+TEST(SeqTest, sketchSameAsWindowScan) {
+    std::mt19937 generator(11);
+    // short kmers over few letters give many equal kmers in a window
+    for (const auto &alphabet : {string("ACGT"), string("AC"), string("A")}) {
+        for (uint32_t k = 1; k < 16; k += 2) {
+            for (uint32_t w = 1; w < 20; w += 3) {
+                for (uint32_t length : {k + w - 2, k + w - 1, k + w, (uint32_t) 300}) {
+                    const auto seq = random_sequence(generator, length, alphabet);
+                    Seq s(0, "0", seq, w, k);
+                    const auto expected = window_scan_sketch(seq, w, k);
+                    EXPECT_EQ(expected, std::set<Minimizer>(s.sketch.begin(), s.sketch.end()))
+                                        << "w=" << w << " k=" << k << " seq=" << seq;
+                    EXPECT_EQ(expected.size(), s.sketch.size());
+                    for (uint32_t i = 1; i < s.sketch.size(); ++i)
+                        EXPECT_LT(s.sketch[i - 1].pos.start, s.sketch[i].pos.start);
+                }
+            }
+        }
+    }
+}
+
+// the sketch of each run of ACGT bases in seq, at its position in seq
+std::set<Minimizer> window_scan_sketch_of_runs(const string &seq, const uint32_t w, const uint32_t k) {
+    std::set<Minimizer> sketch;
+    size_t start = 0;
+    while (start < seq.length()) {
+        size_t end = start;
+        while (end < seq.length() and nt4(seq[end]) < 4)
+            ++end;
+        for (const auto &minimizer : window_scan_sketch(seq.substr(start, end - start), w, k))
+            sketch.insert(Minimizer(minimizer.kmer, minimizer.pos.start + start, minimizer.pos.get_end() + start,
+                                    minimizer.strand));
+        start = end + 1;
+    }
+    return sketch;
+}
+
+TEST(SeqTest, sketchSplitsReadAtN) {
+    Seq s(0, "0", "AGCTAATGTGTTAGCTAATGTGTT", 3, 3);
+    EXPECT_EQ((uint32_t) 0, s.num_ambiguous_bases);
+    s.initialize(1, "1", "AGCTAATGTGTTNGCTAATGTGTT", 3, 3);
+    EXPECT_EQ((uint32_t) 1, s.num_ambiguous_bases);
+    std::set<Minimizer> expected;
+    for (const auto &minimizer : window_scan_sketch("AGCTAATGTGTT", 3, 3))
+        expected.insert(minimizer);
+    for (const auto &minimizer : window_scan_sketch("GCTAATGTGTT", 3, 3))
+        expected.insert(Minimizer(minimizer.kmer, minimizer.pos.start + 13, minimizer.pos.get_end() + 13,
+                                  minimizer.strand));
+    EXPECT_EQ(expected, std::set<Minimizer>(s.sketch.begin(), s.sketch.end()));
+
+    // runs too short for a window add nothing
+    s.initialize(2, "2", "NAGCTNNAGCTAATGTGTTRAG", 3, 3);
+    EXPECT_EQ((uint32_t) 4, s.num_ambiguous_bases);
+    EXPECT_EQ(window_scan_sketch_of_runs("NAGCTNNAGCTAATGTGTTRAG", 3, 3),
+              std::set<Minimizer>(s.sketch.begin(), s.sketch.end()));
+    s.initialize(3, "3", "NNNNNNNNNNNNNNNN", 3, 3);
+    EXPECT_TRUE(s.sketch.empty());
+
+    // the sketch of a read after one with ambiguous bases is as if it were sketched alone
+    s.initialize(4, "4", "AGCTAATGTGTTAGCTAATGTGTT", 3, 3);
+    EXPECT_EQ((uint32_t) 0, s.num_ambiguous_bases);
+    EXPECT_EQ(window_scan_sketch("AGCTAATGTGTTAGCTAATGTGTT", 3, 3), std::set<Minimizer>(s.sketch.begin(), s.sketch.end()));
+
+    std::mt19937 generator(3);
+    for (uint32_t k = 1; k < 16; k += 2) {
+        for (uint32_t w = 1; w < 20; w += 3) {
+            const auto seq = random_sequence(generator, 400, "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTN");
+            s.initialize(5, "5", seq, w, k);
+            EXPECT_EQ(window_scan_sketch_of_runs(seq, w, k), std::set<Minimizer>(s.sketch.begin(), s.sketch.end()))
+                                << "w=" << w << " k=" << k << " seq=" << seq;
+        }
+    }
+}
@@ -10,10 +10,15 @@
 #include "index.h"
 #include "inthash.h"
 #include "seq.h"
+#include "read_index.h"
 #include <stdint.h>
 #include <iostream>
+#include <fstream>
 #include <algorithm>
 #include <vector>
+#include <random>
+#include <thread>
+#include <sys/stat.h>
 
 
 using namespace std;
@@ -137,6 +142,57 @@ TEST(UtilsTest, readPrgFile_with_offset) {
     EXPECT_EQ(prgs[2]->id, (uint)8);
 }
 
+TEST(UtilsTest, readPrgFile_with_threads) {
+    std::vector<std::shared_ptr<LocalPRG>> serial_prgs;
+    read_prg_file(serial_prgs, "../../test/test_cases/prg0123.fa", 2);
+    read_prg_file(serial_prgs, "../../test/test_cases/prg4567.fa", 2 + serial_prgs.size());
+    read_prg_file(serial_prgs, "../../test/test_cases/prg0.fa", 2 + serial_prgs.size());
+
+    for (const auto threads : {2, 3, 8}) {
+        std::vector<std::shared_ptr<LocalPRG>> prgs;
+        read_prg_file(prgs, "../../test/test_cases/prg0123.fa", 2, threads);
+        read_prg_file(prgs, "../../test/test_cases/prg4567.fa", 2 + prgs.size(), threads);
+        read_prg_file(prgs, "../../test/test_cases/prg0.fa", 2 + prgs.size(), threads);
+        ASSERT_EQ(serial_prgs.size(), prgs.size());
+        for (uint32_t i = 0; i != prgs.size(); ++i) {
+            EXPECT_EQ(serial_prgs[i]->id, prgs[i]->id);
+            EXPECT_EQ(serial_prgs[i]->name, prgs[i]->name);
+            EXPECT_EQ(serial_prgs[i]->seq, prgs[i]->seq);
+            EXPECT_EQ(serial_prgs[i]->prg, prgs[i]->prg);
+        }
+    }
+}
+
+TEST(UtilsTest, loadPRGKmergraphsOnDemand) {
+    uint32_t w = 1, k = 3;
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    read_prg_file(prgs, "../../test/test_cases/prg0123.fa");
+    auto index = std::make_shared<Index>();
+    index_prgs(prgs, index, w, k, "../../test/test_cases/kmer_prgs");
+    ASSERT_EQ(prgs.size(), index->min_path_lengths.size());
+
+    std::vector<std::shared_ptr<LocalPRG>> lazy_prgs;
+    read_prg_file(lazy_prgs, "../../test/test_cases/prg0123.fa");
+    load_PRG_kmergraphs_on_demand(lazy_prgs, w, k, "../../test/test_cases/prg0123.fa", *index);
+    for (uint32_t i = 0; i != prgs.size(); ++i) {
+        EXPECT_EQ(prgs[i]->kmer_prg.min_path_length(), index->min_path_lengths[i]);
+        EXPECT_EQ(prgs[i]->kmer_prg.min_path_length(), lazy_prgs[i]->min_path_length());
+        EXPECT_TRUE(lazy_prgs[i]->kmer_prg.nodes.empty());
+    }
+
+    lazy_prgs[1]->load_kmer_prg();
+    EXPECT_EQ(prgs[1]->kmer_prg, lazy_prgs[1]->kmer_prg);
+    EXPECT_FALSE(lazy_prgs[1]->kmer_prg.sorted_nodes.empty());
+    EXPECT_TRUE(lazy_prgs[2]->kmer_prg.nodes.empty());
+
+    // without min path lengths in the index, the kmer graph is loaded to find it
+    lazy_prgs.clear();
+    read_prg_file(lazy_prgs, "../../test/test_cases/prg0123.fa");
+    load_PRG_kmergraphs_on_demand(lazy_prgs, w, k, "../../test/test_cases/prg0123.fa", Index());
+    EXPECT_EQ(prgs[2]->kmer_prg.min_path_length(), lazy_prgs[2]->min_path_length());
+    EXPECT_EQ(prgs[2]->kmer_prg, lazy_prgs[2]->kmer_prg);
+}
+
 TEST(UtilsTest, addReadHits) {
     // initialize minihits container
     auto minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
@@ -275,6 +331,133 @@ TEST(UtilsTest, addReadHits) {
     index->clear();
 }
 
+TEST(UtilsTest, addReadHits_skipsMaskedMinimizers) {
+    KmerHash hash;
+    auto index = std::make_shared<Index>();
+    prg::Path p;
+    p.initialize(Interval(0, 3));
+    pair<uint64_t, uint64_t> kh = hash.kmerhash("AAC", 3);
+    index->add_record(min(kh.first, kh.second), 1, p, 0, (kh.first < kh.second));
+    index->add_record(min(kh.first, kh.second), 2, p, 0, (kh.first < kh.second));
+    index->add_record(min(kh.first, kh.second), 3, p, 0, (kh.first < kh.second));
+    p.initialize(Interval(1, 4));
+    kh = hash.kmerhash("ACG", 3);
+    index->add_record(min(kh.first, kh.second), 1, p, 0, (kh.first < kh.second));
+
+    auto minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
+    auto s = std::make_shared<Seq>(Seq(0, "read", "AACG", 1, 3));
+    EXPECT_EQ((uint)0, add_read_hits(s, minimizer_hits, index));
+    EXPECT_EQ((uint)4, minimizer_hits->uhits.size());
+
+    // AAC has 3 records, so is masked when at most 2 are allowed
+    index->mask_frequent_minimizers(2);
+    minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
+    EXPECT_EQ((uint)1, add_read_hits(s, minimizer_hits, index));
+    EXPECT_EQ((uint)1, minimizer_hits->uhits.size());
+    EXPECT_EQ((uint)1, (*minimizer_hits->uhits.begin())->prg_id);
+}
+
+TEST(UtilsTest, radixSort) {
+    std::mt19937_64 generator(1);
+    for (const uint64_t mask : {0ULL, 0xffULL, (1ULL << 30) - 1, ~0ULL}) {
+        std::vector<std::pair<uint64_t, uint32_t>> items, expected;
+        for (uint32_t i = 0; i != 5000; ++i)
+            items.emplace_back(generator() & mask & ~0xfULL, i);
+        expected = items;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [](const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b) {
+                             return a.first < b.first;
+                         });
+        radix_sort(items);
+        EXPECT_EQ(expected, items);
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> items;
+    radix_sort(items);
+    EXPECT_TRUE(items.empty());
+}
+
+TEST(UtilsTest, addReadBatchHits) {
+    // an index of the kmers of some random sequence, with a few repeated kmers and one masked
+    std::mt19937_64 generator(1);
+    std::string genome;
+    for (uint32_t i = 0; i != 3000; ++i)
+        genome += "ACGT"[generator() % 4];
+    genome += genome.substr(0, 200);
+    const uint32_t w = 5, k = 11;
+    auto index = std::make_shared<Index>();
+    Seq genome_sequence(0, "genome", genome, 1, k);
+    for (const auto &minimizer : genome_sequence.sketch) {
+        prg::Path p;
+        p.initialize(minimizer.pos);
+        index->add_record(minimizer.kmer, minimizer.pos.start % 3, p, minimizer.pos.start % 7, minimizer.strand);
+    }
+    const auto masked_kmer = genome_sequence.sketch[genome_sequence.sketch.size() / 2].kmer;
+    prg::Path p;
+    p.initialize(Interval(0, k));
+    for (uint32_t i = 0; i != 3; ++i)
+        index->add_record(masked_kmer, 10 + i, p, 0, true);
+    index->mask_frequent_minimizers(2);
+
+    std::vector<std::shared_ptr<Seq>> reads;
+    for (uint32_t i = 0; i != 40; ++i) {
+        const auto start = generator() % (genome.size() - 150);
+        auto read = genome.substr(start, 150);
+        read[generator() % read.size()] = 'A';
+        reads.push_back(std::make_shared<Seq>(i, std::to_string(i), read, w, k));
+    }
+
+    // same hits whether read by read or in a batch, while building and once frozen
+    for (const auto frozen : {false, true}) {
+        if (frozen)
+            index->freeze();
+        auto minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
+        auto batch_hits = std::make_shared<MinimizerHits>(MinimizerHits());
+        uint32_t num_masked = 0;
+        ReadBatch batch;
+        for (const auto &read : reads) {
+            num_masked += add_read_hits(read, minimizer_hits, index);
+            batch.add(*read);
+        }
+        EXPECT_EQ(num_masked, add_read_batch_hits(batch, batch_hits, index));
+        minimizer_hits->sort();
+        batch_hits->sort();
+        EXPECT_FALSE(minimizer_hits->hits.empty());
+        ASSERT_EQ(minimizer_hits->hits.size(), batch_hits->hits.size());
+        auto it = batch_hits->hits.begin();
+        for (const auto &hit : minimizer_hits->hits) {
+            EXPECT_EQ(*hit, **it);
+            ++it;
+        }
+    }
+}
+
+TEST(UtilsTest, readBatch_fullAtMaxHits) {
+    Seq read(0, "read", "ACGTACGGTCATTGACAGTCAAGTCAAGCCAGTAGTCATGCATGCCCAGTTG", 1, 5);
+    ReadBatch batch(3 * read.sketch.size());
+    for (uint32_t i = 0; i != 3; ++i) {
+        EXPECT_FALSE(batch.is_full());
+        batch.add(read);
+    }
+    EXPECT_TRUE(batch.is_full());
+
+    // at two hits per minimizer, half as many minimizers fill the next batch
+    batch.found_hits(6 * read.sketch.size());
+    batch.clear();
+    EXPECT_FALSE(batch.is_full());
+    batch.add(read);
+    EXPECT_FALSE(batch.is_full());
+    batch.add(read);
+    EXPECT_TRUE(batch.is_full());
+
+    // and with no hits, no more than max_hits minimizers
+    batch.found_hits(0);
+    EXPECT_EQ(batch.max_hits, batch.max_minimizers);
+    batch.clear();
+    batch.found_hits(1);
+    EXPECT_EQ(batch.max_hits, batch.max_minimizers);
+}
+
 TEST(UtilsTest, filter_clusters2) {
     deque<Interval> d = {Interval(0, 10)};
     prg::Path p;
@@ -705,6 +888,58 @@ TEST(UtilsTest, biggerInferLocalPRGOrderForRead) {
     delete pg;
 }*/
 
+TEST(UtilsTest, clusterReadHits_ofReadsTogetherAsOfEachAlone) {
+    std::vector<std::shared_ptr<LocalPRG>> prgs;
+    read_prg_file(prgs, "../../test/test_cases/updatevcf_test.fa");
+    auto index = std::make_shared<Index>();
+    const uint32_t w = 1, k = 15;
+    for (const auto &prg : prgs)
+        prg->minimizer_sketch(index, w, k);
+
+    // reads along paths of each PRG, some reverse complemented, and one along two PRGs
+    std::vector<std::string> reads;
+    for (const auto &prg : prgs) {
+        const auto top = LocalPRG::string_along_path(prg->prg.top_path());
+        const auto bottom = LocalPRG::string_along_path(prg->prg.bottom_path());
+        reads.push_back(top.substr(0, 500));
+        reads.push_back(rev_complement(bottom.substr(bottom.size() / 2, 500)));
+    }
+    reads.push_back(reads[0] + reads[2]);
+
+    // clusters are sets of pointers to hits, so are compared by the hits they point to
+    const auto hits_of = [](const std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> &clusters) {
+        std::set<std::vector<MinimizerHit>> hits;
+        for (const auto &cluster : clusters) {
+            std::vector<MinimizerHit> cluster_hits;
+            for (const auto &hit : cluster)
+                cluster_hits.push_back(*hit);
+            hits.insert(cluster_hits);
+        }
+        return hits;
+    };
+    const float fraction_kmers_required_for_cluster = 0.5 / exp(0.11 * k);
+    const uint32_t expected_number_kmers_in_short_read_sketch = std::numeric_limits<uint32_t>::max();
+    auto read = std::make_shared<Seq>(0, "", "", w, k);
+    auto hits_together = std::make_shared<MinimizerHits>();
+    std::set<std::vector<MinimizerHit>> clusters_alone;
+    for (uint32_t i = 0; i != reads.size(); ++i) {
+        read->initialize(i, "read", reads[i], w, k);
+        add_read_hits(read, hits_together, index);
+        auto hits_alone = std::make_shared<MinimizerHits>();
+        add_read_hits(read, hits_alone, index);
+        std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> clusters_of_hits;
+        cluster_read_hits(clusters_of_hits, prgs, hits_alone, 250, fraction_kmers_required_for_cluster, 10,
+                          expected_number_kmers_in_short_read_sketch);
+        const auto hits = hits_of(clusters_of_hits);
+        clusters_alone.insert(hits.begin(), hits.end());
+    }
+    std::set<std::set<MinimizerHitPtr, pComp>, clusterComp> clusters_together;
+    cluster_read_hits(clusters_together, prgs, hits_together, 250, fraction_kmers_required_for_cluster, 10,
+                      expected_number_kmers_in_short_read_sketch);
+    EXPECT_LE(reads.size(), clusters_alone.size());
+    EXPECT_EQ(clusters_alone, hits_of(clusters_together));
+}
+
 TEST(UtilsTest, pangraphFromReadFile) {
     auto minimizer_hits = std::make_shared<MinimizerHits>(MinimizerHits());
     KmerHash hash;
@@ -939,6 +1174,82 @@ TEST(UtilsTest, pangraphFromReadFile) {
     pg_exp.add_node(2, "2", 0, mhs_dummy.hits);
     pg_exp.add_node(3, "3", 0, mhs_dummy.hits);
     pg_exp.add_node(0, "0", 0, mhs_dummy.hits);
+    EXPECT_EQ(pg_exp, *pangraph);
+
+    // reads streamed through a pipe rather than from a regular file
+    const string fifo_path = "utils_test_reads.fifo";
+    remove(fifo_path.c_str());
+    ASSERT_EQ(0, mkfifo(fifo_path.c_str(), 0600));
+    std::thread writer([&fifo_path]() {
+        ofstream(fifo_path) << ifstream("../../test/test_cases/read2.fq").rdbuf();
+    });
+    pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    minimizer_hits->clear();
+    pangraph_from_read_file(fifo_path, minimizer_hits, pangraph, index, prgs, 1, 3, 1, 0.1, 1, 5000000, false, false,
+                            300, false, read_index_path(fifo_path, "."));
+    writer.join();
+    EXPECT_EQ(pg_exp, *pangraph);
+    EXPECT_FALSE(ifstream(read_index_path(fifo_path, ".")).is_open());
+    remove(fifo_path.c_str());
+
+    // finding the hits of batches of reads by sort merge gives the same graph
+    pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    minimizer_hits->clear();
+    pangraph_from_read_file("../../test/test_cases/read2.fa", minimizer_hits, pangraph, index, prgs, 1, 3, 1, 0.1, 1,
+                            5000000, false, false, 300, true);
+    EXPECT_EQ(pg_exp, *pangraph);
+
+    // mapping with several threads gives the same graph, also over jobs of many reads, and the read index is saved
+    // where asked rather than beside the reads
+    const auto read_index_filepath = read_index_path("../../test/test_cases/read2.fa", ".");
+    remove(read_index_filepath.c_str());
+    pangraph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+    pangraph_from_read_file("../../test/test_cases/read2.fa", minimizer_hits, pangraph, index, prgs, 1, 3, 1, 0.1, 1,
+                            5000000, false, false, 300, false, read_index_filepath, 4);
+    EXPECT_EQ(pg_exp, *pangraph);
+    EXPECT_TRUE(ReadIndex("../../test/test_cases/read2.fa", read_index_filepath).is_valid());
+    EXPECT_FALSE(ifstream("../../test/test_cases/read2.fa.read_index.bin").is_open());
+    remove(read_index_filepath.c_str());
+
+    // reads padded with non ACGT bases, which have no hits, so that there are a few jobs without too many hits
+    ofstream handle("utils_test_many_reads.fa");
+    for (uint32_t i = 0; i != 3000; ++i)
+        handle << ">read" << i << "\n" << (i % 7 == 0 ? "" : "AGTTATGCTAGCTACTTACGGTA") << string(1000, 'N') << "\n";
+    handle.close();
+    const auto map_reads = [&](const uint32_t threads, const bool sort_merge_hits, const uint32_t genome_size,
+                               const uint32_t max_covg) {
+        auto graph = std::make_shared<pangenome::Graph>(pangenome::Graph());
+        pangraph_from_read_file("utils_test_many_reads.fa", minimizer_hits, graph, index, prgs, 1, 3, 1, 0.1, 1,
+                                genome_size, false, false, max_covg, sort_merge_hits, "", threads);
+        return graph;
+    };
+    const auto expect_same_graph = [](const std::shared_ptr<pangenome::Graph> &expected,
+                                      const std::shared_ptr<pangenome::Graph> &graph) {
+        ASSERT_EQ(expected->nodes.size(), graph->nodes.size());
+        for (const auto &node : expected->nodes)
+            EXPECT_EQ(node.second->covg, graph->nodes[node.first]->covg);
+        ASSERT_EQ(expected->reads.size(), graph->reads.size());
+        for (const auto &read : expected->reads) {
+            ASSERT_EQ((size_t) 1, graph->reads.count(read.first));
+            const auto &nodes = graph->reads[read.first]->nodes;
+            ASSERT_EQ(read.second->nodes.size(), nodes.size());
+            for (uint32_t i = 0; i != nodes.size(); ++i)
+                EXPECT_EQ(read.second->nodes[i]->prg_id, nodes[i]->prg_id);
+        }
+    };
+    const auto expected = map_reads(1, false, 5000000, 300);
+    EXPECT_EQ(pg_exp, *expected);
+    for (const auto &graph : {map_reads(3, false, 5000000, 300), map_reads(4, true, 5000000, 300)})
+        expect_same_graph(expected, graph);
+
+    // reaching max_covg part way through the reads stops at the same read however many threads there are
+    const auto expected_stopped = map_reads(1, false, 100000, 1);
+    EXPECT_LT((size_t) 0, expected_stopped->reads.size());
+    EXPECT_GT(expected->reads.size(), expected_stopped->reads.size());
+    for (const auto &graph : {map_reads(1, true, 100000, 1), map_reads(3, false, 100000, 1),
+                              map_reads(4, true, 100000, 1)})
+        expect_same_graph(expected_stopped, graph);
+    remove("utils_test_many_reads.fa");
 
     index->clear();
 }